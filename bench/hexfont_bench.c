@@ -0,0 +1,1713 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "hexfont.h"
+#include "hexfont_atlas.h"
+#include "hexfont_bits.h"
+#include "hexfont_color.h"
+#include "hexfont_dispatch.h"
+#include "hexfont_hex.h"
+#include "hexfont_layout.h"
+#include "hexfont_list.h"
+#include "hexfont_render.h"
+#include "hexfont_scale.h"
+#include "hexfont_shared.h"
+#include "hexfont_subset.h"
+#include "hexfont_term.h"
+#include "hexfont_transform.h"
+#include "hexfont_utf8.h"
+
+// Number of glyph strings decoded per run
+#define HEXFONT_BENCH_DECODE_GLYPHS 65536
+
+// Number of characters in the dense and mixed synthetic fonts
+#define HEXFONT_BENCH_FONT_LENGTH 57000
+#define HEXFONT_BENCH_FONT_FIRST_CODEPOINT 0x20
+
+// The sparse font skips up to this many codepoints between characters
+#define HEXFONT_BENCH_SPARSE_MAX_STEP 64
+
+// Number of lookups per run
+#define HEXFONT_BENCH_LOOKUPS (1 << 22)
+
+// Characters looked up by each call to hexfont_get_utf8_batch
+#define HEXFONT_BENCH_BATCH 128
+
+// Glyph rows expanded to color pixels per run
+#define HEXFONT_BENCH_COLOR_SPANS (1 << 20)
+
+// Lines appended to the log which is laid out, and the width it wraps at
+#define HEXFONT_BENCH_LAYOUT_LINES 1000
+#define HEXFONT_BENCH_LAYOUT_WIDTH 320
+
+// Lines of text drawn through an atlas, and characters on each
+#define HEXFONT_BENCH_ATLAS_LINES 4096
+#define HEXFONT_BENCH_ATLAS_LINE_LENGTH 48
+
+// CJK unified ideographs which the text is made of
+#define HEXFONT_BENCH_CJK_FIRST 0x4e00
+#define HEXFONT_BENCH_CJK_COUNT 20992
+
+// Characters shown on a terminal per run, and the size of an overview page
+#define HEXFONT_BENCH_TERM_CHARACTERS 4096
+#define HEXFONT_BENCH_TERM_COLUMNS 16
+#define HEXFONT_BENCH_TERM_ROWS 16
+
+// Size of the text scanned for a subset
+#define HEXFONT_BENCH_CORPUS_SIZE (4 * 1024 * 1024)
+
+// Number of times the text is drawn per run
+#define HEXFONT_BENCH_RENDER_LINES 20000
+
+// Bytes handed to hexfont_loader_feed at a time, the size of a pipe buffer page
+#define HEXFONT_BENCH_FEED_CHUNK 4096
+
+// Each benchmark is repeated and the fastest run is reported
+#define HEXFONT_BENCH_REPEAT 5
+
+#ifndef HEXFONT_BENCH_EXAMPLE_FONT
+#define HEXFONT_BENCH_EXAMPLE_FONT "examples/iso-8859-15.hex"
+#endif
+
+// The hash table which hexfont_get used originally, kept here for comparison
+typedef struct hexfont_bench_node {
+    hexfont_character *value;
+    struct hexfont_bench_node *next;
+
+} hexfont_bench_node;
+
+typedef struct hexfont_bench_buckets {
+    hexfont_bench_node **buckets;
+    uint32_t length;
+
+} hexfont_bench_buckets;
+
+/**
+ * A font which the load, lookup and scan benchmarks are run against.
+ * The data is kept in memory and also written to a file.
+  */
+typedef struct hexfont_bench_input {
+    const char *name;
+    char *data;
+    size_t data_len;
+    char file[32];
+    uint8_t glyph_height;
+
+    // Codepoints of the font in file order, and a random mix of
+    // those with some missing ones
+    uint32_t *codepoints;
+    uint32_t length;
+    uint32_t *random_codepoints;
+
+} hexfont_bench_input;
+
+/**
+ * Measurements of one benchmark, ops and bytes are per run
+  */
+typedef struct hexfont_bench_result {
+    uint64_t ops;
+    uint64_t bytes;
+    double best;
+    int runs;
+    double start;
+    uint64_t start_allocations;
+    uint64_t allocations;
+
+    // Of the fastest run, where the CPU's counter can be read
+    bool cache_misses_counted;
+    uint64_t start_cache_misses;
+    uint64_t cache_misses;
+
+    // Memory held by the font being looked at, if that is of interest
+    uint64_t font_bytes;
+
+} hexfont_bench_result;
+
+typedef void (*hexfont_bench_span_function)(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+typedef const bool (*hexfont_bench_decode_function)(uint8_t * const out, const char * const hex, const size_t out_len);
+
+static const double hexfont_bench_now();
+static const uint32_t hexfont_bench_random();
+static const long hexfont_bench_peak_rss();
+static const bool hexfont_bench_cache_misses(uint64_t * const count);
+static void hexfont_bench_peak_rss_reset();
+/**
+ * Cache misses of this thread so far, counted by the CPU. false where
+ * there is no such counter, as under many virtual machines.
+*/
+static const bool hexfont_bench_cache_misses(uint64_t * const count) {
+    *count = 0;
+#ifdef __linux__
+    static int fd = -2;
+    if (fd == -2) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    return fd >= 0 && read(fd, count, sizeof(*count)) == sizeof(*count);
+#else
+    return false;
+#endif
+}
+
+static void hexfont_bench_begin(hexfont_bench_result * const result, const uint64_t ops, const uint64_t bytes);
+static void hexfont_bench_start(hexfont_bench_result * const result);
+static void hexfont_bench_stop(hexfont_bench_result * const result);
+static void hexfont_bench_report(hexfont_bench_result * const result, const char *name, const char *variant, const char *input);
+static const bool hexfont_bench_decode_sscanf(uint8_t * const out, const char * const hex, const size_t out_len);
+static void hexfont_bench_decode(const char *name, hexfont_bench_decode_function decode, const char *hex, const size_t glyph_chars_len);
+static char * const hexfont_bench_synthetic_font(const uint32_t length, const uint32_t max_step, const int wide_percent);
+static char * const hexfont_bench_read_file(const char *file);
+static const bool hexfont_bench_input_init(hexfont_bench_input * const input, const char *name, char * const data, const uint8_t glyph_height);
+static void hexfont_bench_input_destroy(hexfont_bench_input * const input);
+static void hexfont_bench_load(hexfont_bench_input * const input);
+static void hexfont_bench_get(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_get_pixel(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_destroy(hexfont_bench_input * const input);
+static void hexfont_bench_get_buckets(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_list(hexfont_bench_input * const inputs, const size_t count);
+static void hexfont_bench_load_threads(hexfont_bench_input * const input);
+static void hexfont_bench_render(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_transform(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_scale(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_compact(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_shared(hexfont_bench_input * const input);
+static void hexfont_bench_subset(hexfont_bench_input * const input);
+static void hexfont_bench_batch(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_color(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_layout(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_atlas(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_term(hexfont_bench_input * const input, hexfont * const font);
+static void hexfont_bench_dump_fprintf(hexfont_character * const c, FILE *fp);
+static void hexfont_bench_color_span(const char *variant, hexfont_bench_span_function span, const __hexfont_color_pen * const pen, const char *format);
+static const size_t hexfont_bench_utf8_encode(char * const out, const uint32_t codepoint);
+static inline hexfont_character * const hexfont_bench_buckets_get(hexfont_bench_buckets * const table, const uint32_t codepoint);
+
+// Keeps the compiler from dropping the work being measured
+static volatile uintptr_t hexfont_bench_sink;
+
+// Allocations made through malloc, calloc and realloc so far
+static uint64_t hexfont_bench_allocations;
+
+// Only the first result is printed without a separator
+static bool hexfont_bench_first_result = true;
+
+
+int main(void) {
+    printf("{\n");
+    printf("  \"repeat\": %d,\n", HEXFONT_BENCH_REPEAT);
+#ifdef HEXFONT_BENCH_WRAP_MALLOC
+    printf("  \"allocations_counted\": true,\n");
+#else
+    printf("  \"allocations_counted\": false,\n");
+#endif
+    printf("  \"benchmarks\": [");
+
+    // Random upper case glyph strings, like the ones found in unifont.hex
+    static const char digits[] = "0123456789ABCDEF";
+    const size_t glyph_chars_lens[] = { 32, 64 };
+
+    size_t l = 0;
+    for (l=0; l<sizeof(glyph_chars_lens)/sizeof(glyph_chars_lens[0]); l++) {
+        const size_t glyph_chars_len = glyph_chars_lens[l];
+        const size_t stride = glyph_chars_len + 1;
+        char * const hex = malloc(stride * HEXFONT_BENCH_DECODE_GLYPHS);
+
+        // Each glyph string is NUL terminated like a line read by the loader
+        size_t i = 0;
+        for (i=0; i<stride * HEXFONT_BENCH_DECODE_GLYPHS; i++) {
+            hex[i] = (i % stride == glyph_chars_len) ? '\0' : digits[hexfont_bench_random() % 16];
+        }
+
+        hexfont_bench_decode("sscanf", hexfont_bench_decode_sscanf, hex, glyph_chars_len);
+        hexfont_bench_decode("scalar", __hexfont_hex_decode_scalar, hex, glyph_chars_len);
+#ifdef HEXFONT_HEX_HAVE_X86
+        if (__hexfont_dispatch_cpu() >= __HEXFONT_DISPATCH_SSE2) {
+            hexfont_bench_decode("sse2", __hexfont_hex_decode_sse2, hex, glyph_chars_len);
+        }
+        if (__hexfont_dispatch_cpu() >= __HEXFONT_DISPATCH_AVX2) {
+            hexfont_bench_decode("avx2", __hexfont_hex_decode_avx2, hex, glyph_chars_len);
+        }
+#endif
+        hexfont_bench_decode("dispatch", __hexfont_hex_decode, hex, glyph_chars_len);
+
+        free(hex);
+    }
+
+    // The example font is read in as it is, the others are generated
+    // from a fixed seed so that every run sees the same data
+    hexfont_bench_input inputs[4];
+    size_t count = 0;
+
+    char * const example_data = hexfont_bench_read_file(HEXFONT_BENCH_EXAMPLE_FONT);
+    if (example_data && hexfont_bench_input_init(&inputs[count], "iso-8859-15", example_data, 16)) {
+        count++;
+    }
+    if (hexfont_bench_input_init(&inputs[count], "dense", hexfont_bench_synthetic_font(HEXFONT_BENCH_FONT_LENGTH, 1, 0), 16)) {
+        count++;
+    }
+    if (hexfont_bench_input_init(&inputs[count], "sparse", hexfont_bench_synthetic_font(UINT32_MAX, HEXFONT_BENCH_SPARSE_MAX_STEP, 25), 16)) {
+        count++;
+    }
+    if (hexfont_bench_input_init(&inputs[count], "mixed", hexfont_bench_synthetic_font(HEXFONT_BENCH_FONT_LENGTH, 1, 50), 16)) {
+        count++;
+    }
+
+    size_t i = 0;
+    for (i=0; i<count; i++) {
+        hexfont_bench_load(&inputs[i]);
+
+        hexfont * const font = hexfont_load_data(inputs[i].data, inputs[i].glyph_height);
+        hexfont_bench_get(&inputs[i], font);
+        hexfont_bench_get_pixel(&inputs[i], font);
+        hexfont_bench_get_buckets(&inputs[i], font);
+        hexfont_bench_compact(&inputs[i], font);
+        hexfont_destroy(font);
+
+        hexfont_bench_destroy(&inputs[i]);
+    }
+
+    // Loading in other ways and rendering only use the last, mixed font
+    if (count > 0) {
+        hexfont_bench_load_threads(&inputs[count - 1]);
+
+        hexfont * const font = hexfont_load_data(inputs[count - 1].data, inputs[count - 1].glyph_height);
+        hexfont_bench_render(&inputs[count - 1], font);
+        hexfont_bench_transform(&inputs[count - 1], font);
+        hexfont_bench_scale(&inputs[count - 1], font);
+        hexfont_bench_batch(&inputs[count - 1], font);
+        hexfont_bench_color(&inputs[count - 1], font);
+        hexfont_bench_layout(&inputs[count - 1], font);
+        hexfont_bench_atlas(&inputs[count - 1], font);
+        hexfont_bench_term(&inputs[count - 1], font);
+        hexfont_destroy(font);
+
+        hexfont_bench_shared(&inputs[count - 1]);
+        hexfont_bench_subset(&inputs[count - 1]);
+    }
+
+    hexfont_bench_list(inputs, count);
+
+    for (i=0; i<count; i++) {
+        hexfont_bench_input_destroy(&inputs[i]);
+    }
+
+    printf("\n  ],\n");
+    printf("  \"peak_rss_kb\": %ld\n", hexfont_bench_peak_rss());
+    printf("}\n");
+
+    return EXIT_SUCCESS;
+}
+
+#ifdef HEXFONT_BENCH_WRAP_MALLOC
+// Linked with --wrap so that the calls made by the library end up here
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    __atomic_add_fetch(&hexfont_bench_allocations, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    __atomic_add_fetch(&hexfont_bench_allocations, 1, __ATOMIC_RELAXED);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&hexfont_bench_allocations, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static const double hexfont_bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift32, so that the generated fonts don't depend on the C library
+static const uint32_t hexfont_bench_random() {
+    static uint32_t state = 1;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static const long hexfont_bench_peak_rss() {
+    // VmHWM can be reset between benchmarks, ru_maxrss can't
+    FILE * const fp = fopen("/proc/self/status", "r");
+    if (fp) {
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), fp)) {
+            if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+                break;
+            }
+        }
+        fclose(fp);
+        if (kb >= 0) {
+            return kb;
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void hexfont_bench_peak_rss_reset() {
+    // Linux resets the peak to the current RSS, elsewhere this does nothing
+    FILE * const fp = fopen("/proc/self/clear_refs", "w");
+    if (fp) {
+        fputs("5", fp);
+        fclose(fp);
+    }
+}
+
+static void hexfont_bench_begin(hexfont_bench_result * const result, const uint64_t ops, const uint64_t bytes) {
+    result->ops = ops;
+    result->bytes = bytes;
+    result->best = 0;
+    result->runs = 0;
+    result->allocations = 0;
+    result->font_bytes = 0;
+    result->cache_misses_counted = false;
+    result->cache_misses = 0;
+    hexfont_bench_peak_rss_reset();
+}
+
+static void hexfont_bench_start(hexfont_bench_result * const result) {
+    result->start_allocations = __atomic_load_n(&hexfont_bench_allocations, __ATOMIC_RELAXED);
+    hexfont_bench_cache_misses(&result->start_cache_misses);
+    result->start = hexfont_bench_now();
+}
+
+static void hexfont_bench_stop(hexfont_bench_result * const result) {
+    const double elapsed = hexfont_bench_now() - result->start;
+    uint64_t cache_misses;
+    const bool counted = hexfont_bench_cache_misses(&cache_misses);
+    result->allocations = __atomic_load_n(&hexfont_bench_allocations, __ATOMIC_RELAXED) - result->start_allocations;
+
+    if (result->runs == 0 || elapsed < result->best) {
+        result->best = elapsed;
+        result->cache_misses_counted = counted;
+        result->cache_misses = cache_misses - result->start_cache_misses;
+    }
+    result->runs++;
+}
+
+static void hexfont_bench_report(hexfont_bench_result * const result, const char *name, const char *variant, const char *input) {
+    const double seconds = (result->best > 0) ? result->best : 1e-9;
+
+    printf("%s\n    {\"name\": \"%s\", \"variant\": \"%s\", \"input\": \"%s\", ",
+            (hexfont_bench_first_result) ? "" : ",",
+            name,
+            variant,
+            input);
+    printf("\"ops\": %llu, \"ns_per_op\": %.3f, ",
+            (unsigned long long)result->ops,
+            seconds * 1e9 / result->ops);
+    if (result->bytes > 0) {
+        printf("\"mb_per_s\": %.3f, ", result->bytes / seconds / (1024 * 1024));
+    }
+    else {
+        printf("\"mb_per_s\": null, ");
+    }
+#ifdef HEXFONT_BENCH_WRAP_MALLOC
+    printf("\"allocations\": %llu, ", (unsigned long long)result->allocations);
+#else
+    printf("\"allocations\": null, ");
+#endif
+    if (result->cache_misses_counted) {
+        printf("\"cache_misses\": %llu, ", (unsigned long long)result->cache_misses);
+    }
+    else {
+        printf("\"cache_misses\": null, ");
+    }
+    if (result->font_bytes > 0) {
+        printf("\"font_bytes\": %llu, ", (unsigned long long)result->font_bytes);
+    }
+    else {
+        printf("\"font_bytes\": null, ");
+    }
+    printf("\"peak_rss_kb\": %ld}", hexfont_bench_peak_rss());
+    fflush(stdout);
+
+    hexfont_bench_first_result = false;
+}
+
+// The decoder which the loader used originally
+static const bool hexfont_bench_decode_sscanf(uint8_t * const out, const char * const hex, const size_t out_len) {
+    size_t i = 0;
+    for (i=0; i<out_len; i++) {
+        if (sscanf(hex + 2*i, "%02hhx", out+i) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The dump which hexfont_dump_character did originally, a call for each pixel
+static void hexfont_bench_dump_fprintf(hexfont_character * const c, FILE *fp) {
+    int16_t by, bx;
+    for (by=0; by<c->height; by++) {
+        for (bx=0; bx<c->width; bx++) {
+            if (hexfont_character_get_pixel(c, bx, by)) {
+                fprintf(fp, "# ");
+            }
+            else {
+                fprintf(fp, ". ");
+            }
+        }
+        fprintf(fp, "\n");
+    }
+}
+
+static void hexfont_bench_decode(const char *name, hexfont_bench_decode_function decode, const char *hex, const size_t glyph_chars_len) {
+    const size_t glyph_len = glyph_chars_len / HEXFONT_HEX_CHARS_PER_BYTE;
+    uint8_t glyph[64];
+    uint32_t checksum = 0;
+
+    hexfont_bench_result result;
+    hexfont_bench_begin(&result, HEXFONT_BENCH_DECODE_GLYPHS, (uint64_t)glyph_chars_len * HEXFONT_BENCH_DECODE_GLYPHS);
+
+    int r = 0;
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+
+        size_t i = 0;
+        for (i=0; i<HEXFONT_BENCH_DECODE_GLYPHS; i++) {
+            decode(glyph, hex + i*(glyph_chars_len + 1), glyph_len);
+            checksum += glyph[i % glyph_len];
+        }
+
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_sink += checksum;
+
+    hexfont_bench_report(&result, "decode", name, (glyph_chars_len == 32) ? "8x16" : "16x16");
+}
+
+/**
+ * A font with up to length characters starting from the first codepoint,
+ * with up to max_step codepoints between them. Roughly wide_percent of
+ * the glyphs are 16 pixels wide, the rest are 8.
+*/
+static char * const hexfont_bench_synthetic_font(const uint32_t length, const uint32_t max_step, const int wide_percent) {
+    static const char digits[] = "0123456789ABCDEF";
+    const size_t line_len = 7 + 2*64 + 1;
+    size_t capacity = line_len * 1024;
+    size_t used = 0;
+    char *data = malloc(capacity);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    uint32_t codepoint = HEXFONT_BENCH_FONT_FIRST_CODEPOINT;
+    uint32_t i = 0;
+    for (i=0; i<length && codepoint<=HEXFONT_MAX_CODEPOINT; i++) {
+        const size_t glyph_chars_len = ((int)(hexfont_bench_random() % 100) < wide_percent) ? 64 : 32;
+
+        if (capacity - used < line_len + 1) {
+            char * const grown = realloc(data, capacity * 2);
+            if (grown == NULL) {
+                free(data);
+                return NULL;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+
+        char *p = data + used;
+        p += sprintf(p, "%04X:", codepoint);
+        size_t j = 0;
+        for (j=0; j<glyph_chars_len; j++) {
+            *p++ = digits[hexfont_bench_random() % 16];
+        }
+        *p++ = '\n';
+        used = p - data;
+
+        codepoint += (max_step > 1) ? 1 + hexfont_bench_random() % max_step : 1;
+    }
+    data[used] = '\0';
+
+    return data;
+}
+
+static char * const hexfont_bench_read_file(const char *file) {
+    FILE * const fp = fopen(file, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    const long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char * const data = (size >= 0) ? malloc(size + 1) : NULL;
+    if (data && fread(data, 1, size, fp) != (size_t)size) {
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+    if (data) {
+        data[size] = '\0';
+    }
+    fclose(fp);
+
+    return data;
+}
+
+static const bool hexfont_bench_input_init(hexfont_bench_input * const input, const char *name, char * const data, const uint8_t glyph_height) {
+    if (data == NULL) {
+        return false;
+    }
+
+    input->name = name;
+    input->data = data;
+    input->data_len = strlen(data);
+    input->glyph_height = glyph_height;
+    input->codepoints = NULL;
+    input->random_codepoints = NULL;
+
+    // The file based loaders need a real file
+    strcpy(input->file, "/tmp/hexfont_bench_XXXXXX");
+    const int fd = mkstemp(input->file);
+    if (fd == -1) {
+        free(data);
+        return false;
+    }
+    const bool written = write(fd, data, input->data_len) == (ssize_t)input->data_len;
+    close(fd);
+
+    hexfont * const font = hexfont_load_data(data, glyph_height);
+    if (!written || font == NULL || font->length == 0) {
+        if (font) {
+            hexfont_destroy(font);
+        }
+        unlink(input->file);
+        free(data);
+        return false;
+    }
+
+    input->length = font->length;
+    input->codepoints = malloc(font->length * sizeof(uint32_t));
+    uint32_t i = 0;
+    for (i=0; i<font->length; i++) {
+        input->codepoints[i] = font->characters[i].codepoint;
+    }
+
+    // Codepoints from the font, plus one in eight which are most likely missing
+    const uint32_t last = input->codepoints[font->length - 1];
+    input->random_codepoints = malloc(HEXFONT_BENCH_LOOKUPS * sizeof(uint32_t));
+    for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+        const uint32_t n = hexfont_bench_random();
+        input->random_codepoints[i] = (n % 8 == 0) ?
+            (n >> 3) % (last + 1) :
+            input->codepoints[(n >> 3) % font->length];
+    }
+
+    hexfont_destroy(font);
+
+    return true;
+}
+
+static void hexfont_bench_input_destroy(hexfont_bench_input * const input) {
+    unlink(input->file);
+    free(input->data);
+    free(input->codepoints);
+    free(input->random_codepoints);
+}
+
+static void hexfont_bench_load(hexfont_bench_input * const input) {
+    hexfont_bench_result result;
+    int r = 0;
+
+    hexfont_bench_begin(&result, input->length, input->data_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        hexfont * const font = hexfont_load(input->file, input->glyph_height);
+        hexfont_bench_stop(&result);
+        hexfont_destroy(font);
+    }
+    hexfont_bench_report(&result, "hexfont_load", "file", input->name);
+
+    hexfont_bench_begin(&result, input->length, input->data_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        hexfont * const font = hexfont_load_flags(input->file, input->glyph_height, HEXFONT_LOAD_DEDUP);
+        hexfont_bench_stop(&result);
+        hexfont_destroy(font);
+    }
+    hexfont_bench_report(&result, "hexfont_load", "dedup", input->name);
+
+    hexfont_bench_begin(&result, input->length, input->data_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        hexfont * const font = hexfont_load_data(input->data, input->glyph_height);
+        hexfont_bench_stop(&result);
+        hexfont_destroy(font);
+    }
+    hexfont_bench_report(&result, "hexfont_load_data", "memory", input->name);
+
+    // Chunks the size a pipe hands over, which split most lines somewhere
+    hexfont_bench_begin(&result, input->length, input->data_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        hexfont_loader * const loader = hexfont_loader_create(input->glyph_height, 0);
+        size_t offset = 0;
+        for (offset=0; offset<input->data_len; offset+=HEXFONT_BENCH_FEED_CHUNK) {
+            const size_t left = input->data_len - offset;
+            hexfont_loader_feed(loader, input->data + offset,
+                                (left < HEXFONT_BENCH_FEED_CHUNK) ? left : HEXFONT_BENCH_FEED_CHUNK);
+        }
+        hexfont * const font = hexfont_loader_finish(loader);
+        hexfont_bench_stop(&result);
+        hexfont_destroy(font);
+    }
+    hexfont_bench_report(&result, "hexfont_loader_feed", "4k_chunks", input->name);
+}
+
+static void hexfont_bench_get(hexfont_bench_input * const input, hexfont * const font) {
+    hexfont_bench_result result;
+    uintptr_t checksum = 0;
+    uint32_t i = 0;
+    int r = 0;
+
+    hexfont_bench_begin(&result, HEXFONT_BENCH_LOOKUPS, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+            checksum += (uintptr_t)hexfont_get(font, input->random_codepoints[i]);
+        }
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_get", "random", input->name);
+
+    hexfont_bench_begin(&result, HEXFONT_BENCH_LOOKUPS, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+            checksum += (uintptr_t)hexfont_get(font, input->codepoints[i % input->length]);
+        }
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_get", "sequential", input->name);
+
+    hexfont_bench_sink += checksum;
+}
+
+static void hexfont_bench_get_pixel(hexfont_bench_input * const input, hexfont * const font) {
+    // Every pixel of every glyph, row by row
+    uint64_t pixels = 0;
+    uint64_t bytes = 0;
+    uint32_t i = 0;
+    for (i=0; i<font->length; i++) {
+        const hexfont_character * const c = &font->characters[i];
+        pixels += (uint64_t)c->height * (c->glyph_len / c->height) * HEXFONT_BYTE_WIDTH;
+        bytes += c->glyph_len;
+    }
+
+    hexfont_bench_result result;
+    uint32_t checksum = 0;
+    int r = 0;
+
+    hexfont_bench_begin(&result, pixels, bytes);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<font->length; i++) {
+            hexfont_character * const c = &font->characters[i];
+            const size_t width = (c->glyph_len / c->height) * HEXFONT_BYTE_WIDTH;
+            size_t by, bx;
+            for (by=0; by<c->height; by++) {
+                for (bx=0; bx<width; bx++) {
+                    checksum += hexfont_character_get_pixel(c, bx, by);
+                }
+            }
+        }
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_character_get_pixel", "scan", input->name);
+
+    hexfont_bench_sink += checksum;
+}
+
+static void hexfont_bench_destroy(hexfont_bench_input * const input) {
+    hexfont_bench_result result;
+    int r = 0;
+
+    hexfont_bench_begin(&result, input->length, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont * const font = hexfont_load_data(input->data, input->glyph_height);
+        hexfont_bench_start(&result);
+        hexfont_destroy(font);
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_destroy", "eager", input->name);
+}
+
+static void hexfont_bench_get_buckets(hexfont_bench_input * const input, hexfont * const font) {
+    // Rebuild the original modulo buckets, one malloc per node
+    hexfont_bench_buckets table;
+    table.length = font->length;
+    table.buckets = calloc(table.length, sizeof(hexfont_bench_node *));
+
+    uint32_t i = 0;
+    for (i=0; i<font->length; i++) {
+        hexfont_bench_node * const node = malloc(sizeof(hexfont_bench_node));
+        node->value = &font->characters[i];
+        node->next = NULL;
+
+        hexfont_bench_node **tail = &table.buckets[node->value->codepoint % table.length];
+        while (*tail) {
+            tail = &(*tail)->next;
+        }
+        *tail = node;
+    }
+
+    hexfont_bench_result result;
+    uintptr_t checksum = 0;
+    int r = 0;
+
+    hexfont_bench_begin(&result, HEXFONT_BENCH_LOOKUPS, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+            checksum += (uintptr_t)hexfont_bench_buckets_get(&table, input->random_codepoints[i]);
+        }
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "buckets_get", "random", input->name);
+
+    hexfont_bench_sink += checksum;
+
+    for (i=0; i<table.length; i++) {
+        hexfont_bench_node *tmp, *iter = table.buckets[i];
+        while (iter) {
+            tmp = iter;
+            iter = iter->next;
+            free(tmp);
+        }
+    }
+    free(table.buckets);
+}
+
+static inline hexfont_character * const hexfont_bench_buckets_get(hexfont_bench_buckets * const table, const uint32_t codepoint) {
+    hexfont_bench_node const * iter = table->buckets[codepoint % table->length];
+    while (iter && iter->value->codepoint != codepoint) {
+        iter = iter->next;
+    }
+
+    return (iter) ? iter->value : NULL;
+}
+
+static void hexfont_bench_list(hexfont_bench_input * const inputs, const size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // Every font as a fallback for the ones before it
+    hexfont_list * const fonts = hexfont_list_create(NULL);
+    size_t i = 0;
+    for (i=0; i<count; i++) {
+        hexfont_list_append(fonts, hexfont_load_data(inputs[i].data, inputs[i].glyph_height));
+    }
+
+    // Codepoints from all of the fonts
+    uint32_t * const codepoints = malloc(HEXFONT_BENCH_LOOKUPS * sizeof(uint32_t));
+    for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+        codepoints[i] = inputs[i % count].random_codepoints[i];
+    }
+
+    hexfont_bench_result result;
+    uintptr_t checksum = 0;
+    int r = 0;
+
+    hexfont_bench_begin(&result, HEXFONT_BENCH_LOOKUPS, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+            checksum += (uintptr_t)hexfont_list_get(fonts, codepoints[i]);
+        }
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_list_get", "random", "all");
+
+    hexfont_bench_sink += checksum;
+
+    free(codepoints);
+    hexfont_list_destroy(fonts);
+}
+
+static void hexfont_bench_load_threads(hexfont_bench_input * const input) {
+    static const char * const variants[] = { "1", "2", "4", "8" };
+    const unsigned int threads[] = { 1, 2, 4, 8 };
+
+    hexfont_bench_result result;
+    int r = 0;
+
+    size_t t = 0;
+    for (t=0; t<sizeof(threads)/sizeof(threads[0]); t++) {
+        hexfont_bench_begin(&result, input->length, input->data_len);
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            hexfont * const font = hexfont_load_parallel(input->file, input->glyph_height, threads[t]);
+            hexfont_bench_stop(&result);
+            hexfont_destroy(font);
+        }
+        hexfont_bench_report(&result, "hexfont_load_parallel", variants[t], input->name);
+    }
+
+    // Lazy loading, then touching a typical working set of characters
+    hexfont_bench_begin(&result, input->length, input->data_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        hexfont * const font = hexfont_load_lazy(input->file, input->glyph_height);
+        uint32_t codepoint = 0;
+        for (codepoint=0x20; codepoint<0x220; codepoint++) {
+            hexfont_get(font, codepoint);
+        }
+        hexfont_bench_stop(&result);
+        hexfont_destroy(font);
+    }
+    hexfont_bench_report(&result, "hexfont_load_lazy", "512 glyphs", input->name);
+}
+
+static void hexfont_bench_render(hexfont_bench_input * const input, hexfont * const font) {
+    static const char text[] = "The quick brown fox jumps over the lazy dog 0123456789 !#$%&()*+";
+    const size_t text_len = strlen(text);
+
+    hexfont_bitmap bitmap;
+    bitmap.width = 1024;
+    bitmap.height = 64;
+    bitmap.stride = bitmap.width / HEXFONT_BYTE_WIDTH;
+    bitmap.data = calloc(bitmap.stride * bitmap.height, 1);
+
+    // Whole rows shifted into place, at every bit offset
+    hexfont_bench_result result;
+    int r = 0;
+
+    hexfont_bench_begin(&result, (uint64_t)HEXFONT_BENCH_RENDER_LINES * text_len, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+
+        int i = 0;
+        for (i=0; i<HEXFONT_BENCH_RENDER_LINES; i++) {
+            hexfont_render_utf8(font, &bitmap, NULL, i % 8, (i % 3) * 16, text);
+        }
+
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_render_utf8", "rows", input->name);
+
+    // A pixel at a time, which is what callers had to do before
+    hexfont_bench_begin(&result, (uint64_t)HEXFONT_BENCH_RENDER_LINES / 10 * text_len, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+
+        int i = 0;
+        for (i=0; i<HEXFONT_BENCH_RENDER_LINES / 10; i++) {
+            int32_t x = i % 8;
+            const int32_t y = (i % 3) * 16;
+            size_t j = 0;
+            for (j=0; j<text_len; j++) {
+                hexfont_character * const c = hexfont_get(font, (uint8_t)text[j]);
+                size_t by, bx;
+                for (by=0; by<c->height; by++) {
+                    for (bx=0; bx<c->width; bx++) {
+                        if (hexfont_character_get_pixel(c, bx, by)) {
+                            const size_t px = x + bx;
+                            bitmap.data[(y + by) * bitmap.stride + px / 8] |= 0x80 >> (px % 8);
+                        }
+                    }
+                }
+                x += c->width + HEXFONT_RENDER_LETTER_SPACING;
+            }
+        }
+
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_render_utf8", "pixels", input->name);
+
+    // Only the metrics, as a layout pass would
+    int32_t width = 0;
+    hexfont_bench_begin(&result, (uint64_t)HEXFONT_BENCH_RENDER_LINES * text_len, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+
+        int i = 0;
+        for (i=0; i<HEXFONT_BENCH_RENDER_LINES; i++) {
+            width += hexfont_measure_utf8(font, text, NULL, 0, NULL);
+        }
+
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_measure_utf8", "metrics", input->name);
+    hexfont_bench_sink += width;
+
+    free(bitmap.data);
+}
+
+static void hexfont_bench_transform(hexfont_bench_input * const input, hexfont * const font) {
+    // Room for the largest glyph in any layout
+    uint8_t out[256];
+    uint32_t checksum = 0;
+    uint32_t i = 0;
+
+    hexfont_bench_result result;
+    int r = 0;
+
+    // Column-major pages a pixel at a time, which is what drivers had to do before
+    hexfont_bench_begin(&result, font->length, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<font->length; i++) {
+            hexfont_character * const c = &font->characters[i];
+            const size_t width = (c->glyph_len / c->height) * HEXFONT_BYTE_WIDTH;
+            memset(out, 0, sizeof(out));
+            size_t by, bx;
+            for (by=0; by<c->height; by++) {
+                for (bx=0; bx<width; bx++) {
+                    if (hexfont_character_get_pixel(c, bx, by)) {
+                        out[(by / 8) * width + bx] |= 1 << (by % 8);
+                    }
+                }
+            }
+            checksum += out[i % 16];
+        }
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "transform_pages", "pixels", input->name);
+
+    const char * const names[] = { "scalar", "sse2" };
+    void (* const kernels[])(uint8_t * const, const uint8_t * const, const size_t, const size_t) = {
+        __hexfont_bits_to_pages_scalar,
+#ifdef HEXFONT_BITS_HAVE_X86
+        __hexfont_bits_to_pages_sse2,
+#endif
+    };
+    size_t k = 0;
+    for (k=0; k<sizeof(kernels)/sizeof(kernels[0]); k++) {
+#ifdef HEXFONT_BITS_HAVE_X86
+        if (kernels[k] == __hexfont_bits_to_pages_sse2 && __hexfont_dispatch_cpu() < __HEXFONT_DISPATCH_SSE2) {
+            continue;
+        }
+#endif
+        hexfont_bench_begin(&result, font->length, 0);
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            for (i=0; i<font->length; i++) {
+                hexfont_character * const c = &font->characters[i];
+                kernels[k](out, c->glyph, c->glyph_len / c->height, c->height);
+                checksum += out[i % 16];
+            }
+            hexfont_bench_stop(&result);
+        }
+        hexfont_bench_report(&result, "transform_pages", names[k], input->name);
+    }
+
+    hexfont_bench_begin(&result, font->length, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<font->length; i++) {
+            hexfont_transformed transformed;
+            hexfont_transform_character(&font->characters[i], HEXFONT_TRANSFORM_ROTATE_90, out, &transformed);
+            checksum += out[i % 16];
+        }
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_transform_character", "rotate_90", input->name);
+
+    hexfont_bench_sink += checksum;
+}
+
+static void hexfont_bench_scale(hexfont_bench_input * const input, hexfont * const font) {
+    // Room for the largest glyph at the largest scale
+    uint8_t out[32 * 4 * 4];
+    uint32_t checksum = 0;
+    uint32_t i = 0;
+
+    hexfont_bench_result result;
+    int r = 0;
+
+    const char * const pixels[] = { "pixels_x2", "pixels_x3", "pixels_x4" };
+    const char * const spread[] = { "spread_x2", "spread_x3", "spread_x4" };
+    unsigned int scale = 0;
+    for (scale=2; scale<=4; scale++) {
+        // A block of pixels for every pixel probe
+        hexfont_bench_begin(&result, font->length, 0);
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            for (i=0; i<font->length; i++) {
+                hexfont_character * const c = &font->characters[i];
+                const size_t width = (c->glyph_len / c->height) * HEXFONT_BYTE_WIDTH;
+                const size_t stride = (c->glyph_len / c->height) * scale;
+                memset(out, 0, sizeof(out));
+                size_t by, bx, k, j;
+                for (by=0; by<c->height; by++) {
+                    for (bx=0; bx<width; bx++) {
+                        if (!hexfont_character_get_pixel(c, bx, by)) {
+                            continue;
+                        }
+                        for (k=0; k<scale; k++) {
+                            for (j=0; j<scale; j++) {
+                                const size_t px = bx * scale + j;
+                                out[(by * scale + k) * stride + px / 8] |= 0x80 >> (px % 8);
+                            }
+                        }
+                    }
+                }
+                checksum += out[i % 16];
+            }
+            hexfont_bench_stop(&result);
+        }
+        hexfont_bench_report(&result, "scale_character", pixels[scale - 2], input->name);
+
+        hexfont_bench_begin(&result, font->length, 0);
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            for (i=0; i<font->length; i++) {
+                hexfont_character scaled;
+                hexfont_scale_character(&font->characters[i], scale, out, &scaled);
+                checksum += out[i % 16];
+            }
+            hexfont_bench_stop(&result);
+        }
+        hexfont_bench_report(&result, "hexfont_scale_character", spread[scale - 2], input->name);
+    }
+
+    hexfont_bench_sink += checksum;
+}
+
+static void hexfont_bench_compact(hexfont_bench_input * const input, hexfont * const font) {
+    hexfont * const compact = hexfont_compact(font);
+    if (compact == NULL) {
+        return;
+    }
+
+    // The same random lookups as hexfont_get, reading the glyph as well
+    // so that the compact font has to decode it
+    hexfont * const fonts[] = { font, compact };
+    const char * const names[] = { "eager_glyph", "compact_glyph" };
+    size_t k = 0;
+    for (k=0; k<sizeof(fonts)/sizeof(fonts[0]); k++) {
+        hexfont_memory_stats stats;
+        hexfont_get_memory_stats(fonts[k], &stats);
+
+        hexfont_bench_result result;
+        uintptr_t checksum = 0;
+        uint32_t i = 0;
+        int r = 0;
+
+        hexfont_bench_begin(&result, HEXFONT_BENCH_LOOKUPS, 0);
+        result.font_bytes = stats.arena_bytes + stats.table_bytes;
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+                const hexfont_character * const c = hexfont_get(fonts[k], input->random_codepoints[i]);
+                if (c) {
+                    checksum += c->glyph[c->glyph_len - 1];
+                }
+            }
+            hexfont_bench_stop(&result);
+        }
+        hexfont_bench_report(&result, "hexfont_get", names[k], input->name);
+
+        hexfont_bench_sink += checksum;
+    }
+
+    hexfont_destroy(compact);
+}
+
+static void hexfont_bench_shared(hexfont_bench_input * const input) {
+    hexfont_shared * const shared = hexfont_shared_create(hexfont_load_data(input->data, input->glyph_height));
+    if (shared == NULL) {
+        return;
+    }
+
+    hexfont_bench_result result;
+    uintptr_t checksum = 0;
+    uint32_t i = 0;
+    int r = 0;
+
+    // The worst case, a reference taken for every lookup
+    hexfont_bench_begin(&result, HEXFONT_BENCH_LOOKUPS, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+            hexfont_shared_ref ref;
+            checksum += (uintptr_t)hexfont_get(hexfont_shared_acquire(shared, &ref), input->random_codepoints[i]);
+            hexfont_shared_release(shared, &ref);
+        }
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_shared_acquire", "per_lookup", input->name);
+
+    hexfont_bench_begin(&result, 1, input->data_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        hexfont_shared_replace(shared, hexfont_load_data(input->data, input->glyph_height));
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_shared_replace", "load_data", input->name);
+
+    hexfont_shared_destroy(shared);
+    hexfont_bench_sink += checksum;
+}
+
+static void hexfont_bench_subset(hexfont_bench_input * const input) {
+    // UI strings in a few scripts, mostly ASCII
+    static const char * const strings[] = {
+        "Settings ", "Open file... ", "Grüße, Straße ", "Ça va? ",
+        "Настройки ", "設定を開く ", "Ελληνικά ", "OK ",
+    };
+    const size_t strings_count = sizeof(strings) / sizeof(strings[0]);
+
+    char * const corpus = malloc(HEXFONT_BENCH_CORPUS_SIZE);
+    size_t corpus_len = 0;
+    size_t i = 0;
+    for (i=0; corpus_len + strlen(strings[i % strings_count]) < HEXFONT_BENCH_CORPUS_SIZE; i++) {
+        const size_t len = strlen(strings[i % strings_count]);
+        memcpy(corpus + corpus_len, strings[i % strings_count], len);
+        corpus_len += len;
+    }
+
+    hexfont_bench_result result;
+    uint32_t checksum = 0;
+    int r = 0;
+
+    hexfont_bench_begin(&result, corpus_len, corpus_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        hexfont_subset * const subset = hexfont_subset_create();
+        hexfont_subset_add_utf8(subset, corpus, corpus_len);
+        hexfont_bench_stop(&result);
+        checksum += hexfont_subset_count(subset);
+        hexfont_subset_destroy(subset);
+    }
+    hexfont_bench_report(&result, "hexfont_subset_add_utf8", "ui_strings", input->name);
+
+    // Only the glyphs of the corpus are decoded, against hexfont_load
+    hexfont_subset * const subset = hexfont_subset_create();
+    hexfont_subset_add_utf8(subset, corpus, corpus_len);
+
+    hexfont_bench_begin(&result, input->length, input->data_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        hexfont * const font = hexfont_load_subset(input->file, input->glyph_height, 0, subset);
+        hexfont_bench_stop(&result);
+        checksum += font->length;
+        hexfont_destroy(font);
+    }
+    hexfont_bench_report(&result, "hexfont_load_subset", "ui_strings", input->name);
+
+    hexfont_subset_destroy(subset);
+    free(corpus);
+    hexfont_bench_sink += checksum;
+}
+
+static void hexfont_bench_batch(hexfont_bench_input * const input, hexfont * const font) {
+    // A log line and text which is mostly not ASCII, which stay in the
+    // cache, and text over the whole font, whose glyphs mostly don't
+    static const char * const texts[] = {
+        "2015-06-01 12:00:00.123 INFO  [worker-3] request completed in 12ms status=200 path=/api/v1/fonts",
+        "Привет, мир! 日本語のテキストです。Ελληνικά κείμενα και ASCII",
+        NULL,
+    };
+    static const char * const variants[] = { "log_line", "mixed_text", "random_text" };
+
+    char * const random_text = malloc((size_t)HEXFONT_BENCH_LOOKUPS * 4);
+    size_t random_len = 0;
+    uint32_t i = 0;
+    for (i=0; i<HEXFONT_BENCH_LOOKUPS; i++) {
+        random_len += hexfont_bench_utf8_encode(random_text + random_len, input->random_codepoints[i]);
+    }
+
+    hexfont_character *out[HEXFONT_BENCH_BATCH];
+    hexfont_bench_result result;
+    uintptr_t checksum = 0;
+    size_t t = 0;
+    int r = 0;
+
+    for (t=0; t<sizeof(texts) / sizeof(texts[0]); t++) {
+        // Short texts are done over and over, the random one once
+        const char * const text = (texts[t]) ? texts[t] : random_text;
+        const size_t len = (texts[t]) ? strlen(texts[t]) : random_len;
+        const int times = (texts[t]) ? HEXFONT_BENCH_RENDER_LINES : 1;
+        const char *p = text;
+        uint64_t characters = 0;
+        while (p < text + len) {
+            __hexfont_utf8_next(&p, text + len);
+            characters++;
+        }
+
+        // Decoding and looking up one codepoint at a time
+        hexfont_bench_begin(&result, characters * times, len * times);
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            int k = 0;
+            for (k=0; k<times; k++) {
+                const char *q = text;
+                while (q < text + len) {
+                    const hexfont_character * const c = hexfont_get(font, __hexfont_utf8_next(&q, text + len));
+                    checksum += (c) ? c->glyph[0] : 0;
+                }
+            }
+            hexfont_bench_stop(&result);
+        }
+        hexfont_bench_report(&result, "hexfont_get", variants[t], input->name);
+
+        hexfont_bench_begin(&result, characters * times, len * times);
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            int k = 0;
+            for (k=0; k<times; k++) {
+                size_t offset = 0;
+                while (offset < len) {
+                    size_t consumed;
+                    const size_t n = hexfont_get_utf8_batch(font, text + offset, len - offset, out, NULL, HEXFONT_BENCH_BATCH, &consumed);
+                    size_t j = 0;
+                    for (j=0; j<n; j++) {
+                        checksum += (out[j]) ? out[j]->glyph[0] : 0;
+                    }
+                    offset += consumed;
+                }
+            }
+            hexfont_bench_stop(&result);
+        }
+        hexfont_bench_report(&result, "hexfont_get_utf8_batch", variants[t], input->name);
+    }
+
+    free(random_text);
+    hexfont_bench_sink += checksum;
+}
+
+/**
+ * Glyph rows expanded on their own by each implementation, then whole
+ * lines of text drawn onto a surface. ops are pixels, so pixels per
+ * second are 1e9 / ns_per_op.
+*/
+static void hexfont_bench_color(hexfont_bench_input * const input, hexfont * const font) {
+    static const char text[] = "The quick brown fox jumps over the lazy dog 0123456789 !#$%&()*+";
+    static const hexfont_pixel_format formats[] = { HEXFONT_PIXEL_RGB565, HEXFONT_PIXEL_RGB888, HEXFONT_PIXEL_ARGB8888 };
+    static const char * const format_names[] = { "rgb565", "rgb888", "argb8888" };
+    static const size_t pixel_bytes[] = { 2, 3, 4 };
+
+    const hexfont_colors opaque = { 0xffe0e0e0, 0xff202040, false };
+    const hexfont_colors transparent = { 0xffe0e0e0, 0, true };
+    const int32_t line_width = hexfont_measure_utf8(font, text, NULL, 0, NULL);
+    const uint64_t line_pixels = (uint64_t)line_width * font->glyph_height;
+
+    hexfont_bench_result result;
+    uintptr_t checksum = 0;
+    size_t f = 0;
+    int r = 0;
+
+    for (f=0; f<sizeof(formats) / sizeof(formats[0]); f++) {
+        __hexfont_color_pen pen;
+        __hexfont_color_pen_init(&pen, formats[f], &opaque);
+
+        hexfont_bench_color_span("scalar", __hexfont_color_span_scalar, &pen, format_names[f]);
+#ifdef HEXFONT_COLOR_HAVE_X86
+        if (__hexfont_dispatch_cpu() >= __HEXFONT_DISPATCH_SSE2) {
+            hexfont_bench_color_span("sse2", __hexfont_color_span_sse2, &pen, format_names[f]);
+        }
+        if (__hexfont_dispatch_cpu() >= __HEXFONT_DISPATCH_AVX2) {
+            hexfont_bench_color_span("avx2", __hexfont_color_span_avx2, &pen, format_names[f]);
+        }
+#endif
+        hexfont_bench_color_span("dispatch", __hexfont_color_span, &pen, format_names[f]);
+
+        hexfont_surface surface;
+        surface.width = 1024;
+        surface.height = 64;
+        surface.stride = surface.width * pixel_bytes[f];
+        surface.format = formats[f];
+        surface.data = calloc(surface.stride * surface.height, 1);
+
+        char variant[32];
+        const hexfont_colors * const colors[] = { &opaque, &transparent };
+        size_t k = 0;
+        for (k=0; k<2; k++) {
+            hexfont_bench_begin(&result, HEXFONT_BENCH_RENDER_LINES * line_pixels, HEXFONT_BENCH_RENDER_LINES * line_pixels * pixel_bytes[f]);
+            for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+                hexfont_bench_start(&result);
+
+                int i = 0;
+                for (i=0; i<HEXFONT_BENCH_RENDER_LINES; i++) {
+                    hexfont_render_utf8_color(font, &surface, NULL, i % 8, (i % 3) * 16, colors[k], text);
+                }
+
+                hexfont_bench_stop(&result);
+            }
+            snprintf(variant, sizeof(variant), "%s_%s", format_names[f], (k == 0) ? "opaque" : "transparent");
+            hexfont_bench_report(&result, "hexfont_render_utf8_color", variant, input->name);
+        }
+
+        checksum += surface.data[surface.stride * 8 + 8];
+        free(surface.data);
+    }
+
+    hexfont_bench_sink += checksum;
+}
+
+/**
+ * A log which has lines appended one at a time and is wrapped after
+ * each, by measuring all of it again as callers had to, and by keeping
+ * a layout. Then words in the middle of the whole log are edited.
+ * ops are appended lines or edits.
+*/
+static void hexfont_bench_layout(hexfont_bench_input * const input, hexfont * const font) {
+    static const char line[] = "2015-06-01 12:00:00.123 INFO  [worker-3] request completed in 12ms status=200 path=/api/v1/fonts\n";
+    const size_t line_len = strlen(line);
+
+    char * const text = malloc(HEXFONT_BENCH_LAYOUT_LINES * line_len + 1);
+    hexfont_line * const lines = malloc(HEXFONT_BENCH_LAYOUT_LINES * 4 * sizeof(hexfont_line));
+    hexfont_bench_result result;
+    uint64_t checksum = 0;
+    int r = 0;
+
+    hexfont_bench_begin(&result, HEXFONT_BENCH_LAYOUT_LINES, (uint64_t)HEXFONT_BENCH_LAYOUT_LINES * line_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+
+        size_t len = 0;
+        int i = 0;
+        for (i=0; i<HEXFONT_BENCH_LAYOUT_LINES; i++) {
+            memcpy(text + len, line, line_len + 1);
+            len += line_len;
+
+            size_t line_count;
+            hexfont_measure_utf8(font, text, lines, HEXFONT_BENCH_LAYOUT_LINES * 4, &line_count);
+            checksum += line_count;
+        }
+
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_measure_utf8", "append", input->name);
+
+    hexfont_layout * const layout = hexfont_layout_create(font, HEXFONT_BENCH_LAYOUT_WIDTH);
+    hexfont_bench_begin(&result, HEXFONT_BENCH_LAYOUT_LINES, (uint64_t)HEXFONT_BENCH_LAYOUT_LINES * line_len);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        // Each run starts from an empty log
+        size_t len;
+        hexfont_layout_get_text(layout, &len);
+        hexfont_layout_replace(layout, 0, len, "", 0);
+        hexfont_bench_start(&result);
+
+        int i = 0;
+        for (i=0; i<HEXFONT_BENCH_LAYOUT_LINES; i++) {
+            hexfont_layout_append(layout, line, line_len);
+        }
+
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_layout_append", "append", input->name);
+
+    // "status=200" to "status=404" and back, halfway through the log
+    size_t len;
+    hexfont_layout_get_text(layout, &len);
+    const size_t edit_offset = (len / 2) - ((len / 2) % line_len) + (strstr(line, "200") - line);
+
+    hexfont_bench_begin(&result, HEXFONT_BENCH_LAYOUT_LINES, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+
+        int i = 0;
+        for (i=0; i<HEXFONT_BENCH_LAYOUT_LINES; i++) {
+            hexfont_layout_replace(layout, edit_offset, 3, (i & 1) ? "200" : "404", 3);
+        }
+
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_layout_replace", "edit", input->name);
+
+    size_t line_count;
+    hexfont_layout_get_lines(layout, &line_count);
+    checksum += line_count;
+
+    hexfont_layout_destroy(layout);
+    free(lines);
+    free(text);
+    hexfont_bench_sink += checksum;
+}
+
+/**
+ * Lines of Latin text, and of CJK text with a Zipf like spread of
+ * characters as in real text, drawn with the font's own characters and
+ * through atlases. The usage atlas is counted from the same text.
+ * ops are characters.
+*/
+static void hexfont_bench_atlas(hexfont_bench_input * const input, hexfont * const font) {
+    static const char latin[] = "the quick brown fox jumps over the lazy dog, THE QUICK BROWN FOX 0123456789.";
+    static const char * const variants[] = { "latin", "cjk" };
+    static const char * const names[] = { "hexfont_render_utf8", "hexfont_atlas_render_utf8", "hexfont_atlas_render_utf8" };
+    static const char * const orders[] = { "font", "by_codepoint", "by_usage" };
+
+    char * const text = malloc((size_t)HEXFONT_BENCH_ATLAS_LINES * (HEXFONT_BENCH_ATLAS_LINE_LENGTH * 4 + 1));
+    hexfont_bitmap bitmap;
+    bitmap.width = 1024;
+    bitmap.height = 16;
+    bitmap.stride = bitmap.width / HEXFONT_BYTE_WIDTH;
+    bitmap.data = calloc(bitmap.stride * bitmap.height, 1);
+
+    hexfont_bench_result result;
+    size_t v = 0;
+    int r = 0;
+
+    for (v=0; v<sizeof(variants) / sizeof(variants[0]); v++) {
+        // The lines are NUL terminated one after another
+        size_t len = 0;
+        int l = 0;
+        for (l=0; l<HEXFONT_BENCH_ATLAS_LINES; l++) {
+            int k = 0;
+            for (k=0; k<HEXFONT_BENCH_ATLAS_LINE_LENGTH; k++) {
+                uint32_t codepoint;
+                if (v == 0) {
+                    codepoint = (uint8_t)latin[hexfont_bench_random() % (sizeof(latin) - 1)];
+                }
+                else {
+                    // Ranks spread evenly over powers of two, then scattered
+                    // over the block so that common characters are far apart
+                    const uint32_t bits = hexfont_bench_random() % 15;
+                    uint32_t rank = ((1u << bits) - 1) + hexfont_bench_random() % (1u << bits);
+                    rank %= HEXFONT_BENCH_CJK_COUNT;
+                    codepoint = HEXFONT_BENCH_CJK_FIRST + (rank * 7919) % HEXFONT_BENCH_CJK_COUNT;
+                }
+                len += hexfont_bench_utf8_encode(text + len, codepoint);
+            }
+            text[len++] = '\0';
+        }
+
+        hexfont_atlas * const atlases[] = {
+            NULL,
+            hexfont_atlas_create(font, HEXFONT_ATLAS_BY_CODEPOINT, NULL, 0),
+            hexfont_atlas_create(font, HEXFONT_ATLAS_BY_USAGE, text, len),
+        };
+
+        size_t a = 0;
+        for (a=0; a<sizeof(atlases) / sizeof(atlases[0]); a++) {
+            int32_t checksum = 0;
+            hexfont_bench_begin(&result, (uint64_t)HEXFONT_BENCH_ATLAS_LINES * HEXFONT_BENCH_ATLAS_LINE_LENGTH, len);
+            for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+                hexfont_bench_start(&result);
+
+                const char *line = text;
+                for (l=0; l<HEXFONT_BENCH_ATLAS_LINES; l++) {
+                    checksum += (atlases[a]) ?
+                            hexfont_atlas_render_utf8(atlases[a], &bitmap, NULL, 0, 0, line) :
+                            hexfont_render_utf8(font, &bitmap, NULL, 0, 0, line);
+                    line += strlen(line) + 1;
+                }
+
+                hexfont_bench_stop(&result);
+            }
+            hexfont_bench_sink += checksum;
+
+            char variant[32];
+            snprintf(variant, sizeof(variant), "%s_%s", variants[v], orders[a]);
+            hexfont_bench_report(&result, names[a], variant, input->name);
+
+            hexfont_atlas_destroy(atlases[a]);
+        }
+    }
+
+    free(bitmap.data);
+    free(text);
+}
+
+static void hexfont_bench_term(hexfont_bench_input * const input, hexfont * const font) {
+    static const char * const modes[] = { "ascii", "half_blocks", "braille", "sixel" };
+
+    // Everything goes to /dev/null, so that only putting it together
+    // and the calls into the kernel are measured
+    FILE * const fp = fopen("/dev/null", "w");
+    const int fd = open("/dev/null", O_WRONLY);
+    if (fp == NULL || fd == -1) {
+        if (fp) {
+            fclose(fp);
+        }
+        if (fd != -1) {
+            close(fd);
+        }
+        return;
+    }
+
+    hexfont_character ** const characters = malloc(HEXFONT_BENCH_TERM_CHARACTERS * sizeof(hexfont_character *));
+    uint32_t codepoint = HEXFONT_BENCH_FONT_FIRST_CODEPOINT;
+    size_t length = 0;
+    while (length < HEXFONT_BENCH_TERM_CHARACTERS && codepoint <= HEXFONT_MAX_CODEPOINT) {
+        hexfont_character * const c = hexfont_get(font, codepoint++);
+        if (c) {
+            characters[length++] = c;
+        }
+    }
+
+    hexfont_bench_result result;
+    size_t i = 0;
+    int r = 0;
+
+    hexfont_bench_begin(&result, length, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<length; i++) {
+            hexfont_bench_dump_fprintf(characters[i], fp);
+        }
+        fflush(fp);
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_dump_character", "fprintf", input->name);
+
+    hexfont_bench_begin(&result, length, 0);
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+        for (i=0; i<length; i++) {
+            hexfont_dump_character(characters[i], fp);
+        }
+        fflush(fp);
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_report(&result, "hexfont_dump_character", "buffered", input->name);
+
+    size_t m = 0;
+    for (m=0; m<sizeof(modes) / sizeof(modes[0]); m++) {
+        int checksum = 0;
+        hexfont_bench_begin(&result, length, 0);
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            for (i=0; i<length; i++) {
+                checksum += hexfont_term_write_character(characters[i], (hexfont_term_mode)m, fd);
+            }
+            hexfont_bench_stop(&result);
+        }
+        hexfont_bench_sink += checksum;
+        hexfont_bench_report(&result, "hexfont_term_write_character", modes[m], input->name);
+    }
+
+    // Whole pages of the same characters, each written at once
+    const uint32_t page = HEXFONT_BENCH_TERM_COLUMNS * HEXFONT_BENCH_TERM_ROWS;
+    const uint32_t pages = HEXFONT_BENCH_TERM_CHARACTERS / page;
+    for (m=0; m<sizeof(modes) / sizeof(modes[0]); m++) {
+        int checksum = 0;
+        hexfont_bench_begin(&result, (uint64_t)pages * page, 0);
+        for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+            hexfont_bench_start(&result);
+            uint32_t p = 0;
+            for (p=0; p<pages; p++) {
+                checksum += hexfont_term_write_overview(
+                                    font,
+                                    HEXFONT_BENCH_FONT_FIRST_CODEPOINT + p * page,
+                                    HEXFONT_BENCH_TERM_COLUMNS,
+                                    HEXFONT_BENCH_TERM_ROWS,
+                                    (hexfont_term_mode)m,
+                                    fd);
+            }
+            hexfont_bench_stop(&result);
+        }
+        hexfont_bench_sink += checksum;
+        hexfont_bench_report(&result, "hexfont_term_write_overview", modes[m], input->name);
+    }
+
+    free(characters);
+    close(fd);
+    fclose(fp);
+}
+
+/**
+ * Random 16 pixel glyph rows expanded one after another along a row
+ * of the surface, as a line of wide glyphs would be
+*/
+static void hexfont_bench_color_span(const char *variant, hexfont_bench_span_function span, const __hexfont_color_pen * const pen, const char *format) {
+    const int32_t width = 16;
+    const size_t row_len = 64 * width * pen->pixel_bytes;
+    uint8_t * const row = calloc(row_len, 1);
+    uint32_t bits[64];
+
+    size_t i = 0;
+    for (i=0; i<64; i++) {
+        bits[i] = hexfont_bench_random() << 16;
+    }
+
+    hexfont_bench_result result;
+    hexfont_bench_begin(&result, (uint64_t)HEXFONT_BENCH_COLOR_SPANS * width, (uint64_t)HEXFONT_BENCH_COLOR_SPANS * width * pen->pixel_bytes);
+
+    int r = 0;
+    for (r=0; r<HEXFONT_BENCH_REPEAT; r++) {
+        hexfont_bench_start(&result);
+
+        for (i=0; i<HEXFONT_BENCH_COLOR_SPANS; i++) {
+            span(row + (i % 64) * width * pen->pixel_bytes, pen, bits[i % 64], width);
+        }
+
+        hexfont_bench_stop(&result);
+    }
+    hexfont_bench_sink += row[row_len - 1];
+    free(row);
+
+    hexfont_bench_report(&result, "color_span", variant, format);
+}
+
+static const size_t hexfont_bench_utf8_encode(char * const out, const uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        out[0] = codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = 0xc0 | (codepoint >> 6);
+        out[1] = 0x80 | (codepoint & 0x3f);
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = 0xe0 | (codepoint >> 12);
+        out[1] = 0x80 | ((codepoint >> 6) & 0x3f);
+        out[2] = 0x80 | (codepoint & 0x3f);
+        return 3;
+    }
+    out[0] = 0xf0 | (codepoint >> 18);
+    out[1] = 0x80 | ((codepoint >> 12) & 0x3f);
+    out[2] = 0x80 | ((codepoint >> 6) & 0x3f);
+    out[3] = 0x80 | (codepoint & 0x3f);
+    return 4;
+}
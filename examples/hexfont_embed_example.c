@@ -0,0 +1,52 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "hexfont.h"
+#include "hexfont_embedded_iso-8859-15.h"
+
+#define HEXFONT_EXAMPLE_TEST_CODEPOINT 0xf6
+
+
+int main(void) {
+    // Ready to use, without loading anything
+    hexfont * const font = hexfont_embedded_iso_8859_15();
+
+    printf("Embedded: %u characters\n", font->length);
+
+    hexfont_character *c =
+                hexfont_get(font, HEXFONT_EXAMPLE_TEST_CODEPOINT);
+    printf("Get: %d -> %p (%ld) -> %02x\n", HEXFONT_EXAMPLE_TEST_CODEPOINT, c, c->glyph_len, c->codepoint);
+
+    hexfont_dump_character(c, stdout);
+
+    printf("Width: %d\n", c->width);
+    printf("Height: %d\n", c->height);
+
+    // Does nothing, but code which doesn't know where a font came from may call it
+    hexfont_destroy(font);
+    printf("Goodbye\n");
+
+    return EXIT_SUCCESS;
+}
@@ -36,7 +36,7 @@ int main(int argc, char **argv) {
     uint16_t glyph_height = strtol(argv[2], &endptr, 10);
     hexfont * const  example_font = hexfont_load(argv[1], glyph_height);
 
-    printf("Loaded: %d characters\n", example_font->length);
+    printf("Loaded: %u characters\n", example_font->length);
 
     hexfont_character *c =
                 hexfont_get(example_font, HEXFONT_EXAMPLE_TEST_CODEPOINT);
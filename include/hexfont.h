@@ -34,6 +34,17 @@ extern "C" {
 
 #define HEXFONT_BYTE_WIDTH 8
 
+// Highest codepoint in Unicode, the loader ignores anything above it
+#define HEXFONT_MAX_CODEPOINT 0x10ffff
+
+// The lookup table splits codepoints into blocks of HEXFONT_PAGE_SIZE
+#define HEXFONT_PAGE_BITS 8
+#define HEXFONT_PAGE_SIZE (1 << HEXFONT_PAGE_BITS)
+#define HEXFONT_PAGE_MASK (HEXFONT_PAGE_SIZE - 1)
+
+// Blank pixels left between one character and the next
+#define HEXFONT_LETTER_SPACING 1
+
 
 // An individual character in the font
 typedef struct hexfont_character {
@@ -45,28 +56,245 @@ typedef struct hexfont_character {
 
 } hexfont_character;
 
-// Linked list node for keeping glyphs in buckets when there are collisions
-typedef struct __hexfont_node {
-    uint16_t key;
-    hexfont_character * value;
-    struct __hexfont_node * next;
+/**
+ * Measurements of a glyph, worked out when it is loaded.
+ * The ink box surrounds the set pixels and is all 0 for a blank glyph.
+ * The bearings are the blank columns on either side of the ink, up to
+ * the advance, which is the character width plus HEXFONT_LETTER_SPACING.
+  */
+typedef struct hexfont_metrics {
+    uint8_t ink_x;
+    uint8_t ink_y;
+    uint8_t ink_width;
+    uint8_t ink_height;
+    uint8_t left_bearing;
+    uint8_t right_bearing;
+    uint16_t advance;
+
+} hexfont_metrics;
+
+// Memory pool which owns the glyphs and lookup table of a font
+struct __hexfont_arena;
 
-} __hexfont_node;
+// Backing store of a font whose characters are produced on demand
+struct __hexfont_source;
+
+/**
+ * Counters and load timings of a font, only kept when HEXFONT_STATS is
+ * defined, see hexfont_get_stats. Lookups are counted by the inline
+ * functions below, in the program which calls them, so it has to be
+ * defined there as well as for the library. Linking the hexfont CMake
+ * target passes it on.
+  */
+typedef struct __hexfont_counters {
+    uint64_t lookups;
+    uint64_t misses;
+    uint64_t list_hits;
+    uint64_t list_misses;
+    uint64_t decodes;
+    uint64_t parse_ns;
+    uint64_t index_ns;
+    uint64_t compact_ns;
+
+} __hexfont_counters;
+
+#ifdef HEXFONT_STATS
+// Counted with a plain load and store rather than a locked add, so that a
+// lookup stays cheap. Counts from threads racing on one font may be lost.
+#define __HEXFONT_ADD(font, counter, n) do { \
+        __hexfont_counters * const __counters = (font)->counters; \
+        if (__counters) { \
+            __atomic_store_n(&__counters->counter, \
+                __atomic_load_n(&__counters->counter, __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED); \
+        } \
+    } while (0)
+#else
+#define __HEXFONT_ADD(font, counter, n) do { } while (0)
+#endif
+#define __HEXFONT_COUNT(font, counter) __HEXFONT_ADD(font, counter, 1)
 
 // A list of code points and a way of looking up code points efficiently
 typedef struct hexfont {
-    __hexfont_node const ** buckets;
-    uint16_t length;
+    // Two level lookup table, see hexfont_get
+    const uint32_t * directory;
+    const uint32_t * pages;
+    uint32_t directory_length;
+
+    hexfont_character * characters;
+    uint32_t length;
+
+    // Indexed like characters, an advance of 0 means not known yet
+    hexfont_metrics * metrics;
+
     uint16_t glyph_height;
+    struct __hexfont_arena * arena;
+    struct __hexfont_source * source;
+
+    // Set for fonts generated by hexfont_embed, which live in read only
+    // memory and are left alone by hexfont_destroy
+    bool embedded;
+
+    // NULL unless built with HEXFONT_STATS
+    __hexfont_counters * counters;
 
 } hexfont;
 
+// A font which is being loaded a piece at a time, see below
+typedef struct hexfont_loader hexfont_loader;
+
+/**
+ * Memory used by a loaded font.
+ * glyph_bytes is what the glyphs would take with a copy per character,
+ * saved_bytes is how much of that is shared between identical glyphs,
+ * or compressed away in a compact font.
+ * arena_bytes is everything held by the font's arena, glyphs and lookup
+ * table included, and table_bytes the characters and metrics arrays.
+ * Glyph figures are only known for fonts loaded from .hex data in one go
+ * and compact fonts.
+  */
+typedef struct hexfont_memory_stats {
+    uint32_t characters;
+    uint32_t unique_glyphs;
+    size_t glyph_bytes;
+    size_t saved_bytes;
+    size_t arena_bytes;
+    size_t table_bytes;
+
+} hexfont_memory_stats;
+
+/**
+ * Shape of a font's lookup table and, when built with HEXFONT_STATS, how
+ * the font has been used.
+ * A lookup is always a directory and a page load, so there are no chains
+ * to walk. What varies is the memory: pages is the number of blocks of
+ * HEXFONT_PAGE_SIZE codepoints which hold any characters, fullest_page
+ * the most characters in one of them and occupancy the share of page
+ * slots in use, which is low for a font scattered over many blocks.
+ * counted is false when the counters aren't kept. Lookups made from
+ * code compiled without HEXFONT_STATS are not counted either way.
+ * lookups and misses are made by hexfont_get and hexfont_get_metrics.
+ * list_hits are lookups through a hexfont_list which this font answered,
+ * so a high count on a fallback font means the fonts before it lack
+ * codepoints which are in use. list_misses are kept by the first font of
+ * a list, for lookups which no font answered.
+ * decodes are characters produced on demand by a lazy, compiled or
+ * compact font. The timings split loading into parsing (reading the
+ * lines and decoding their glyphs), building the lookup table and making
+ * a compact copy.
+  */
+typedef struct hexfont_stats {
+    uint32_t characters;
+    uint32_t directory_length;
+    uint32_t pages;
+    uint32_t fullest_page;
+    double occupancy;
+
+    bool counted;
+    uint64_t lookups;
+    uint64_t misses;
+    uint64_t list_hits;
+    uint64_t list_misses;
+    uint64_t decodes;
+    uint64_t parse_ns;
+    uint64_t index_ns;
+    uint64_t compact_ns;
+
+} hexfont_stats;
+
+// Flags for hexfont_load_flags and hexfont_loader_create
+
+// Keep one copy of each distinct glyph, shared by every codepoint which
+// has it. Glyphs must then be treated as read only.
+#define HEXFONT_LOAD_DEDUP (1 << 0)
+
+// Return the font as hexfont_compact would
+#define HEXFONT_LOAD_COMPACT (1 << 1)
+
 hexfont * const hexfont_load(const char *file, const uint8_t glyph_height);
+hexfont * const hexfont_load_flags(const char *file, const uint8_t glyph_height, const unsigned int flags);
 hexfont * const hexfont_load_data(const char *data, const uint8_t glyph_height);
+
+/**
+ * Load a font from data as it arrives, from a pipe, socket or decompressor.
+ * Each call to hexfont_loader_feed may end anywhere, even in the middle
+ * of a line. Complete lines are parsed straight away and only a line which
+ * is split between calls is copied, so nothing like the whole input is
+ * held at once. feed returns false once out of memory.
+ * hexfont_loader_finish returns the font, or NULL if out of memory, and
+ * hexfont_loader_destroy gives up; either way the loader is freed.
+  */
+hexfont_loader * const hexfont_loader_create(const uint8_t glyph_height, const unsigned int flags);
+const bool hexfont_loader_feed(hexfont_loader * const loader, const void * const data, const size_t len);
+hexfont * const hexfont_loader_finish(hexfont_loader * const loader);
+void hexfont_loader_destroy(hexfont_loader * const loader);
+
+/**
+ * Load a large font using nthreads threads, or one per CPU if nthreads is 0.
+ * The file is split on line boundaries and the parts are parsed concurrently,
+ * the result is the same as that of hexfont_load.
+  */
+hexfont * const hexfont_load_parallel(const char *file, const uint8_t glyph_height, unsigned int nthreads);
+
+/**
+ * Load a font by only recording where each codepoint is in the file.
+ * Glyphs are decoded the first time they are looked up, so start up time
+ * and memory use depend on the characters actually used. The file stays
+ * mapped until the font is destroyed.
+  */
+hexfont * const hexfont_load_lazy(const char *file, const uint8_t glyph_height);
+
+/**
+ * Make a copy of a font which keeps its glyphs compressed, blank rows
+ * are left out and rows which repeat the one above are only marked.
+ * hexfont_get decodes the glyph into a buffer of the calling thread,
+ * which is only good until that thread's next hexfont_get on a compact
+ * font. The copy doesn't depend on font, which can be destroyed.
+  */
+hexfont * const hexfont_compact(hexfont * const font);
 void hexfont_destroy(hexfont * const font);
 void hexfont_dump_character(hexfont_character * const c, FILE *fp);
+void hexfont_get_memory_stats(hexfont * const font, hexfont_memory_stats * const stats);
+
+/**
+ * hexfont_reset_stats zeroes the counters but keeps the load timings.
+ * hexfont_write_stats_json writes the stats and memory stats of a font
+ * as a JSON object.
+  */
+void hexfont_get_stats(hexfont * const font, hexfont_stats * const stats);
+void hexfont_reset_stats(hexfont * const font);
+const bool hexfont_write_stats_json(hexfont * const font, FILE *fp);
+
+/**
+ * Compiled fonts.
+ * hexfont_save_binary writes a font in a compact binary format which
+ * hexfont_load_binary maps into memory and serves without parsing or copying.
+ * Glyphs of a font loaded with hexfont_load_binary are read-only.
+  */
+const bool hexfont_save_binary(hexfont * const font, const char *file);
+hexfont * const hexfont_load_binary(const char *file);
 
-const uint16_t __hexfont_hash_function(const uint32_t codepoint, const uint16_t N);
+/**
+ * Decode UTF-8 text and look up up to max of its codepoints in one go.
+ * The ith codepoint goes in codepoints[i], if that isn't NULL, and its
+ * character in out[i], NULL if the font doesn't have it, so that the
+ * codepoints which couldn't be mapped can be reported. The number of
+ * bytes used is stored in consumed, call again from there for the rest.
+ * Runs of ASCII are decoded eight bytes at a time, the table lookups of
+ * a batch don't wait on each other and the glyphs are prefetched before
+ * the caller gets to them. With glyphs which are not in the cache, as
+ * in long strings in a large font, this roughly halves the cost of each
+ * character compared to hexfont_get.
+ * Characters of a compact font are decoded into one buffer per thread,
+ * so with those only the last entry of out is good, use hexfont_get.
+ * Returns the number of codepoints decoded.
+  */
+const size_t hexfont_get_utf8_batch(hexfont * const font, const char * const text, const size_t len, hexfont_character ** const out, uint32_t * const codepoints, const size_t max, size_t * const consumed);
+
+hexfont_character * const __hexfont_source_get(hexfont * const font, const uint32_t index);
+
+// Character numbers of count codepoints, as __hexfont_find
+void __hexfont_find_batch(hexfont * const font, const uint32_t * const codepoints, uint32_t * const numbers, const size_t count);
+const hexfont_metrics * const __hexfont_metrics_get_slow(hexfont * const font, const uint32_t index);
 
 static inline const bool hexfont_character_get_pixel(hexfont_character * const c, const size_t x, const size_t y) {
     // Number of bytes in one row of the glyph
@@ -81,26 +309,66 @@ static inline const bool hexfont_character_get_pixel(hexfont_character * const c
     return ((c->glyph[byte] << bit) & 0x80) != 0;
 }
 
-static inline hexfont_character * const hexfont_get(hexfont * const font, const uint32_t codepoint) {
-    const uint16_t key = __hexfont_hash_function(codepoint, font->length);
-    if (font->length < key) {
-        return NULL;
+// Character number of a codepoint (index + 1), or 0 if there is no such character
+static inline const uint32_t __hexfont_find(const hexfont * const font, const uint32_t codepoint) {
+    // The directory gives the page for the block holding the codepoint
+    const uint32_t block = codepoint >> HEXFONT_PAGE_BITS;
+    if (block >= font->directory_length) {
+        return 0;
     }
 
-    __hexfont_node const * iter = font->buckets[key];
-    if (iter == NULL) {
-        return NULL;
+    // The page gives the character number
+    return font->pages[
+        ((size_t)font->directory[block] << HEXFONT_PAGE_BITS) | (codepoint & HEXFONT_PAGE_MASK)];
+}
+
+// Character at index (number - 1), or NULL if a source fails to produce it
+static inline hexfont_character * const __hexfont_character_at(hexfont * const font, const uint32_t index) {
+    if (font->source) {
+        return __hexfont_source_get(font, index);
     }
 
-    while (iter && iter->value && iter->value->codepoint != codepoint) {
-        iter = iter->next;
+    return &font->characters[index];
+}
+
+/**
+ * Character of a codepoint, or NULL if it isn't in the font.
+ * A loaded font is never changed by lookups other than the first use of
+ * a lazy or binary character, which is published atomically, so any
+ * number of threads may call this and hexfont_get_metrics at once.
+ * The characters belong to the font and go with hexfont_destroy, see
+ * hexfont_shared.h for replacing a font which other threads are using.
+  */
+static inline hexfont_character * const hexfont_get(hexfont * const font, const uint32_t codepoint) {
+    __HEXFONT_COUNT(font, lookups);
+    const uint32_t number = __hexfont_find(font, codepoint);
+    if (number == 0) {
+        __HEXFONT_COUNT(font, misses);
+        return NULL;
     }
 
-    if (iter == NULL) {
+    return __hexfont_character_at(font, number - 1);
+}
+
+/**
+ * Metrics of a codepoint, or NULL if it isn't in the font.
+ * This only reads the metrics table, except for the first use of a
+ * character in a font loaded with hexfont_load_lazy.
+  */
+static inline const hexfont_metrics * const hexfont_get_metrics(hexfont * const font, const uint32_t codepoint) {
+    __HEXFONT_COUNT(font, lookups);
+    const uint32_t number = __hexfont_find(font, codepoint);
+    if (number == 0) {
+        __HEXFONT_COUNT(font, misses);
         return NULL;
     }
 
-    return iter->value;
+    const hexfont_metrics * const metrics = &font->metrics[number - 1];
+    if (__atomic_load_n(&metrics->advance, __ATOMIC_ACQUIRE) == 0) {
+        return __hexfont_metrics_get_slow(font, number - 1);
+    }
+
+    return metrics;
 }
 
 
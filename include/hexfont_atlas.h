@@ -0,0 +1,103 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_ATLAS_H__
+#define __HEXFONT_ATLAS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+#include "hexfont_render.h"
+
+// Entry of a codepoint which isn't in the atlas
+#define HEXFONT_ATLAS_NONE UINT32_MAX
+
+// Order of the glyphs in an atlas
+typedef enum hexfont_atlas_order {
+    HEXFONT_ATLAS_BY_CODEPOINT,
+
+    // Most used in a sample text first, the rest by codepoint
+    HEXFONT_ATLAS_BY_USAGE,
+
+} hexfont_atlas_order;
+
+/**
+ * The characters of a font as parallel arrays, with every glyph packed
+ * one after another into a single block.
+ * Entry i is codepoints[i], widths[i] pixels wide, and its glyph is the
+ * offsets[i + 1] - offsets[i] bytes at data + offsets[i], glyph_height
+ * rows packed MSB first like any other glyph.
+ * Text is mostly made of a few hundred characters, ordered by usage
+ * their glyphs share a few dozen cache lines however far apart their
+ * codepoints are, which is what a renderer going through CJK text
+ * wants. Ordered by codepoint, a script's glyphs are together.
+  */
+typedef struct hexfont_atlas {
+    uint32_t length;
+    uint16_t glyph_height;
+    const uint32_t *codepoints;
+    const uint16_t *widths;
+    const uint32_t *offsets;
+    const uint8_t *data;
+    size_t data_len;
+
+    // Entries of the font's characters, by character number - 1
+    hexfont *font;
+    const uint32_t *entries;
+
+} hexfont_atlas;
+
+/**
+ * Copy all of the characters of a font into an atlas. With
+ * HEXFONT_ATLAS_BY_USAGE codepoints are counted in the len bytes of
+ * sample, which is otherwise ignored and may be NULL.
+ * The font must outlive the atlas, it is still used for lookups.
+  */
+hexfont_atlas * const hexfont_atlas_create(hexfont * const font, const hexfont_atlas_order order, const char * const sample, const size_t sample_len);
+void hexfont_atlas_destroy(hexfont_atlas * const atlas);
+
+// Entry of a codepoint, or HEXFONT_ATLAS_NONE
+static inline const uint32_t hexfont_atlas_find(const hexfont_atlas * const atlas, const uint32_t codepoint) {
+    const uint32_t number = __hexfont_find(atlas->font, codepoint);
+    return (number) ? atlas->entries[number - 1] : HEXFONT_ATLAS_NONE;
+}
+
+/**
+ * As hexfont_get_utf8_batch, the entries of up to max codepoints of text
+ * with their glyphs already being fetched
+  */
+const size_t hexfont_atlas_find_utf8(const hexfont_atlas * const atlas, const char * const text, const size_t len, uint32_t * const entries, uint32_t * const codepoints, const size_t max, size_t * const consumed);
+
+// As hexfont_render_utf8, with the glyphs of the atlas
+const int32_t hexfont_atlas_render_utf8(const hexfont_atlas * const atlas, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const char *text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_ATLAS_H__
@@ -0,0 +1,86 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_LAYOUT_H__
+#define __HEXFONT_LAYOUT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+#include "hexfont_list.h"
+#include "hexfont_render.h"
+
+// Text broken into lines at a pixel width, see below
+typedef struct hexfont_layout hexfont_layout;
+
+/**
+ * A paragraph of UTF-8 text which is kept broken into lines no wider
+ * than width pixels, measured with the metrics of the font or fonts.
+ * Lines break after a run of spaces, a word which is wider than a whole
+ * line is broken wherever it has to be, and '\n' always ends a line.
+ * Spaces where a line wraps hang past its end, they are left out of its
+ * length and width. With a width of 0 or less lines only end at '\n' and
+ * come out as hexfont_measure_utf8 would give them.
+ *
+ * The layout keeps a copy of the text and the lines it was broken into.
+ * hexfont_layout_replace changes bytes [offset, offset + remove) to the
+ * len bytes of text, and only lays out again from the line before the
+ * change until a line starts where one did before, so appending to a log
+ * costs as much as the new text. Lines after a change in the middle have
+ * their offsets moved, which is cheap but not free.
+ * false is returned when offset or remove are outside of the text and
+ * when out of memory, either way the text and lines are left as they were.
+ *
+ * The fonts must outlive the layout.
+  */
+hexfont_layout * const hexfont_layout_create(hexfont * const font, const int32_t width);
+hexfont_layout * const hexfont_list_layout_create(hexfont_list * const fonts, const int32_t width);
+void hexfont_layout_destroy(hexfont_layout * const layout);
+
+const bool hexfont_layout_append(hexfont_layout * const layout, const char * const text, const size_t len);
+const bool hexfont_layout_replace(hexfont_layout * const layout, const size_t offset, const size_t remove, const char * const text, const size_t len);
+
+// Break all of the text again at another width
+const bool hexfont_layout_set_width(hexfont_layout * const layout, const int32_t width);
+
+/**
+ * The text, which is not NUL terminated, and its lines. There is always
+ * at least one line, empty text is one empty line.
+ * Both are only valid until the layout is next changed.
+  */
+const char * const hexfont_layout_get_text(const hexfont_layout * const layout, size_t * const len);
+const hexfont_line * const hexfont_layout_get_lines(const hexfont_layout * const layout, size_t * const line_count);
+
+// Index of the line which byte offset of the text is part of
+const size_t hexfont_layout_find_line(const hexfont_layout * const layout, const size_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_LAYOUT_H__
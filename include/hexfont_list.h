@@ -31,12 +31,41 @@ extern "C" {
 #include <stdint.h>
 #include "hexfont.h"
 
+// Only this many fonts at the front of a list are covered by its index
+#define HEXFONT_LIST_MAX_INDEXED_FONTS 255
+
+// Character numbers which don't fit beside the font number aren't indexed
+#define HEXFONT_LIST_FONT_SHIFT 24
+#define HEXFONT_LIST_NUMBER_MASK ((1 << HEXFONT_LIST_FONT_SHIFT) - 1)
+
+/**
+ * Lookup table over all of the fonts in a list, laid out like the one in
+ * a hexfont. Each entry holds the font number (index + 1) of the first
+ * font which has the codepoint, and that font's character number.
+  */
+typedef struct __hexfont_list_index {
+    uint32_t *directory;
+    uint32_t *pages;
+    uint32_t directory_length;
+    uint32_t page_count;
+    hexfont *fonts[HEXFONT_LIST_MAX_INDEXED_FONTS];
+    uint32_t font_count;
+
+    // First node whose font is not in the index, if any
+    struct hexfont_list *unindexed;
+
+} __hexfont_list_index;
+
 /**
- * A singly linked list of font/font_metrics pairs
+ * A singly linked list of font/font_metrics pairs.
+ * The head of the list owns the index, which is updated by hexfont_list_append.
+ * Lookups may be made from several threads at once, as with hexfont_get,
+ * but not while the list is being appended to or destroyed.
   */
 typedef struct hexfont_list {
     hexfont *item;
     struct hexfont_list *next;
+    __hexfont_list_index *index;
 
 } hexfont_list;
 
@@ -47,6 +76,88 @@ void hexfont_list_append(hexfont_list * const head, hexfont * const new_item);
 uint16_t hexfont_list_get_length(hexfont_list * const head);
 hexfont * const hexfont_list_get_nth(hexfont_list * const head, int16_t n);
 
+hexfont * const __hexfont_list_find_slow(hexfont_list * const from, const uint32_t codepoint, uint32_t * const number);
+
+/**
+ * The first font in the list which has the codepoint, or NULL if none of
+ * them has it. number is set to the character number in that font.
+  */
+static inline hexfont * const __hexfont_list_find(hexfont_list * const head, const uint32_t codepoint, uint32_t * const number) {
+    if (head == NULL) {
+        return NULL;
+    }
+
+    const __hexfont_list_index * const index = head->index;
+    if (index == NULL) {
+        return __hexfont_list_find_slow(head, codepoint, number);
+    }
+
+    const uint32_t block = codepoint >> HEXFONT_PAGE_BITS;
+    if (block < index->directory_length) {
+        const uint32_t entry = index->pages[
+            ((size_t)index->directory[block] << HEXFONT_PAGE_BITS) | (codepoint & HEXFONT_PAGE_MASK)];
+        if (entry) {
+            hexfont * const font = index->fonts[(entry >> HEXFONT_LIST_FONT_SHIFT) - 1];
+            *number = entry & HEXFONT_LIST_NUMBER_MASK;
+            if (*number == 0) {
+                *number = __hexfont_find(font, codepoint);
+            }
+            return font;
+        }
+    }
+
+    // Fonts past the end of the index are searched one by one
+    if (index->unindexed) {
+        return __hexfont_list_find_slow(index->unindexed, codepoint, number);
+    }
+
+    return NULL;
+}
+
+// As __hexfont_list_find, counting which font answered when built with HEXFONT_STATS
+static inline hexfont * const __hexfont_list_find_counted(hexfont_list * const head, const uint32_t codepoint, uint32_t * const number) {
+    hexfont * const font = __hexfont_list_find(head, codepoint, number);
+    if (font) {
+        __HEXFONT_COUNT(font, list_hits);
+    }
+    else if (head && head->item) {
+        __HEXFONT_COUNT(head->item, list_misses);
+    }
+
+    return font;
+}
+
+/**
+ * Find a codepoint in the first font of the list which has it.
+ * This costs about the same as hexfont_get on a single font, however
+ * many fonts have to be skipped.
+  */
+static inline hexfont_character * const hexfont_list_get(hexfont_list * const head, const uint32_t codepoint) {
+    uint32_t number;
+    hexfont * const font = __hexfont_list_find_counted(head, codepoint, &number);
+    if (font == NULL) {
+        return NULL;
+    }
+
+    return __hexfont_character_at(font, number - 1);
+}
+
+// As hexfont_get_metrics, from the first font in the list which has the codepoint
+static inline const hexfont_metrics * const hexfont_list_get_metrics(hexfont_list * const head, const uint32_t codepoint) {
+    uint32_t number;
+    hexfont * const font = __hexfont_list_find_counted(head, codepoint, &number);
+    if (font == NULL) {
+        return NULL;
+    }
+
+    const hexfont_metrics * const metrics = &font->metrics[number - 1];
+    if (__atomic_load_n(&metrics->advance, __ATOMIC_ACQUIRE) == 0) {
+        return __hexfont_metrics_get_slow(font, number - 1);
+    }
+
+    return metrics;
+}
+
 #ifdef __cplusplus
 }
 #endif
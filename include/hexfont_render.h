@@ -0,0 +1,161 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_RENDER_H__
+#define __HEXFONT_RENDER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+#include "hexfont_list.h"
+
+// Blank pixels left between one character and the next, included in hexfont_metrics.advance
+#define HEXFONT_RENDER_LETTER_SPACING HEXFONT_LETTER_SPACING
+
+/**
+ * A caller owned 1 bit per pixel image.
+ * Each row is packed MSB first, like a glyph, and rows are stride bytes apart.
+  */
+typedef struct hexfont_bitmap {
+    uint8_t *data;
+    size_t stride;
+    int32_t width;
+    int32_t height;
+
+} hexfont_bitmap;
+
+/**
+ * Pixel formats of a hexfont_surface.
+ * RGB565 and ARGB8888 pixels are 16 and 32 bit words in the byte order of
+ * the CPU. RGB888 pixels are 3 bytes, blue first, that is 0xRRGGBB stored
+ * little endian as in most framebuffers.
+  */
+typedef enum hexfont_pixel_format {
+    HEXFONT_PIXEL_RGB565,
+    HEXFONT_PIXEL_RGB888,
+    HEXFONT_PIXEL_ARGB8888,
+
+} hexfont_pixel_format;
+
+// A caller owned color image, rows are stride bytes apart
+typedef struct hexfont_surface {
+    uint8_t *data;
+    size_t stride;
+    int32_t width;
+    int32_t height;
+    hexfont_pixel_format format;
+
+} hexfont_surface;
+
+/**
+ * Colors to draw with, as 0xAARRGGBB whatever the surface format.
+ * With transparent set the background pixels are left as they are.
+  */
+typedef struct hexfont_colors {
+    uint32_t foreground;
+    uint32_t background;
+    bool transparent;
+
+} hexfont_colors;
+
+/**
+ * A line of measured text.
+ * offset and length are in bytes, length doesn't include the '\n'.
+ * width is how far hexfont_render_utf8 would move x for the line.
+  */
+typedef struct hexfont_line {
+    size_t offset;
+    size_t length;
+    int32_t width;
+
+} hexfont_line;
+
+// A rectangle of pixels, used to clip drawing
+typedef struct hexfont_rect {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+
+} hexfont_rect;
+
+/**
+ * Draw text by OR-ing whole glyph rows into the bitmap.
+ * (x, y) is the top left corner of the first character and may be outside
+ * the bitmap. Nothing is drawn outside clip, or outside the bitmap if clip
+ * is NULL. A '\n' moves down by the glyph height and back to x.
+ * Codepoints which are not in the font are skipped.
+ * Returns the x coordinate following the last character.
+  */
+const int32_t hexfont_render_utf8(hexfont * const font, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const char *text);
+
+// As above, each codepoint is drawn using the first font in the list which has it
+const int32_t hexfont_list_render_utf8(hexfont_list * const fonts, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const char *text);
+
+/**
+ * Measure text as hexfont_render_utf8 would draw it, using only the
+ * metrics table and never the glyphs.
+ * Lines are split at '\n', the first max_lines of them are stored in
+ * lines if it isn't NULL. The total number of lines is stored in
+ * line_count if it isn't NULL, their height is that many glyph heights.
+ * Returns the width of the widest line.
+  */
+const int32_t hexfont_measure_utf8(hexfont * const font, const char *text, hexfont_line * const lines, const size_t max_lines, size_t * const line_count);
+
+// As above, each codepoint is measured using the first font in the list which has it
+const int32_t hexfont_list_measure_utf8(hexfont_list * const fonts, const char *text, hexfont_line * const lines, const size_t max_lines, size_t * const line_count);
+
+// Draw a single character with its top left corner at (x, y)
+void hexfont_render_character(hexfont_character * const c, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, const int32_t x, const int32_t y);
+
+/**
+ * As hexfont_render_utf8 and hexfont_render_character, with every pixel
+ * drawn as a scale by scale block. Letter spacing and line height are
+ * scaled as well. Glyphs are spread out a byte at a time, for repeated
+ * text at one scale a hexfont_scale_cache saves doing even that.
+  */
+const int32_t hexfont_render_utf8_scaled(hexfont * const font, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const unsigned int scale, const char *text);
+const int32_t hexfont_list_render_utf8_scaled(hexfont_list * const fonts, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const unsigned int scale, const char *text);
+void hexfont_render_character_scaled(hexfont_character * const c, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, const int32_t x, const int32_t y, const unsigned int scale);
+
+/**
+ * As hexfont_render_utf8 and hexfont_render_character, onto a color
+ * surface. Glyph rows are expanded to pixels up to 16 at a time with
+ * SSE2 or AVX2 where the CPU has them. With an opaque background each
+ * character fills its whole advance, letter spacing included, so that
+ * a line of text is a solid strip.
+  */
+const int32_t hexfont_render_utf8_color(hexfont * const font, hexfont_surface * const surface, const hexfont_rect * const clip, int32_t x, int32_t y, const hexfont_colors * const colors, const char *text);
+const int32_t hexfont_list_render_utf8_color(hexfont_list * const fonts, hexfont_surface * const surface, const hexfont_rect * const clip, int32_t x, int32_t y, const hexfont_colors * const colors, const char *text);
+void hexfont_render_character_color(hexfont_character * const c, hexfont_surface * const surface, const hexfont_rect * const clip, const int32_t x, const int32_t y, const hexfont_colors * const colors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_RENDER_H__
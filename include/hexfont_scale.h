@@ -0,0 +1,64 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_SCALE_H__
+#define __HEXFONT_SCALE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+
+// Scaled copies of the characters of a font, see below
+typedef struct hexfont_scale_cache hexfont_scale_cache;
+
+/**
+ * Scale one character up by a whole factor into out, which must have
+ * room for hexfont_scale_size bytes. result is a character like any
+ * other, with its glyph in out. Returns false if the scaled width or
+ * height would not fit in a character.
+  */
+const size_t hexfont_scale_size(const hexfont_character * const c, const unsigned int scale);
+const bool hexfont_scale_character(const hexfont_character * const c, const unsigned int scale, uint8_t * const out, hexfont_character * const result);
+
+/**
+ * A cache of the characters of a font at one scale.
+ * Each character is scaled the first time it is asked for and can then be
+ * drawn with hexfont_render_character. The characters stay put until the
+ * cache is destroyed. The font must outlive the cache.
+ * Lookups may be made from several threads at once. NULL is returned
+ * when the glyph height times scale would not fit in a character.
+  */
+hexfont_scale_cache * const hexfont_scale_cache_create(hexfont * const font, const unsigned int scale);
+hexfont_character * const hexfont_scale_cache_get(hexfont_scale_cache * const cache, const uint32_t codepoint);
+void hexfont_scale_cache_destroy(hexfont_scale_cache * const cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_SCALE_H__
@@ -0,0 +1,74 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_SHARED_H__
+#define __HEXFONT_SHARED_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+
+// A font used by several threads which can be replaced while in use, see below
+typedef struct hexfont_shared hexfont_shared;
+
+/**
+ * What a reader holds between hexfont_shared_acquire and
+ * hexfont_shared_release
+  */
+typedef struct hexfont_shared_ref {
+    hexfont *font;
+    unsigned int slot;
+
+} hexfont_shared_ref;
+
+/**
+ * Share font, which the handle then owns, between threads.
+ * Readers take the current font with hexfont_shared_acquire, which never
+ * blocks, and may then use it and any characters they get from it until
+ * hexfont_shared_release. Taking a reference costs a couple of atomic
+ * operations, so hold one for a frame or a run of text rather than
+ * taking one per lookup.
+ * hexfont_shared_replace publishes a new font straight away, then waits
+ * until no reader can still be using the old one and destroys it.
+ * hexfont_shared_reload loads a file off to the side first and keeps the
+ * current font if that fails. A thread must not replace the font while
+ * it holds a reference itself.
+  */
+hexfont_shared * const hexfont_shared_create(hexfont * const font);
+hexfont * const hexfont_shared_acquire(hexfont_shared * const shared, hexfont_shared_ref * const ref);
+void hexfont_shared_release(hexfont_shared * const shared, hexfont_shared_ref * const ref);
+void hexfont_shared_replace(hexfont_shared * const shared, hexfont * const font);
+const bool hexfont_shared_reload(hexfont_shared * const shared, const char *file, const uint8_t glyph_height, const unsigned int flags);
+
+// Destroy the handle and its font, there must be no readers left
+void hexfont_shared_destroy(hexfont_shared * const shared);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_SHARED_H__
@@ -0,0 +1,80 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_SUBSET_H__
+#define __HEXFONT_SUBSET_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+
+// Always part of a subset, it is what malformed text decodes to
+#define HEXFONT_SUBSET_FALLBACK 0xfffd
+
+// A set of codepoints which a font is cut down to, see below
+typedef struct hexfont_subset hexfont_subset;
+
+/**
+ * Collect the codepoints used by some text so that only their glyphs need
+ * to be loaded or shipped.
+ * hexfont_subset_add_utf8 may be fed a corpus in pieces which end anywhere,
+ * even in the middle of a sequence, and hexfont_subset_add_file streams
+ * a file through it. Only the set is kept, one bit per codepoint.
+ * Add ranges for text which isn't known up front, a script or a locale.
+  */
+hexfont_subset * const hexfont_subset_create();
+void hexfont_subset_add(hexfont_subset * const subset, const uint32_t codepoint);
+void hexfont_subset_add_range(hexfont_subset * const subset, const uint32_t first, const uint32_t last);
+void hexfont_subset_add_utf8(hexfont_subset * const subset, const char * const text, const size_t len);
+const bool hexfont_subset_add_file(hexfont_subset * const subset, const char *file);
+const bool hexfont_subset_contains(const hexfont_subset * const subset, const uint32_t codepoint);
+const uint32_t hexfont_subset_count(const hexfont_subset * const subset);
+void hexfont_subset_destroy(hexfont_subset * const subset);
+
+/**
+ * Load only the characters of a .hex file which are in subset, in the same
+ * single pass as hexfont_load_flags. Other lines are skipped before their
+ * glyphs are decoded.
+ * hexfont_loader_set_subset does the same for a loader, before anything
+ * is fed to it. The subset must outlive the loader.
+  */
+hexfont * const hexfont_load_subset(const char *file, const uint8_t glyph_height, const unsigned int flags, const hexfont_subset * const subset);
+void hexfont_loader_set_subset(hexfont_loader * const loader, const hexfont_subset * const subset);
+
+/**
+ * Write a font back out as a .hex file, in codepoint order.
+ * Together with hexfont_load_subset this makes a cut down .hex file,
+ * hexfont_save_binary makes a compiled one.
+  */
+const bool hexfont_save_hex(hexfont * const font, const char *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_SUBSET_H__
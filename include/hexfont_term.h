@@ -0,0 +1,80 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_TERM_H__
+#define __HEXFONT_TERM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+#include "hexfont_list.h"
+#include "hexfont_render.h"
+
+/**
+ * Ways of showing pixels on a terminal, the denser ones need a UTF-8
+ * terminal, and sixel one which understands DEC sixel graphics.
+  */
+typedef enum hexfont_term_mode {
+    // "# " and ". " for each pixel, as hexfont_dump_character
+    HEXFONT_TERM_ASCII,
+
+    // One character cell for 1x2 pixels, with the upper and lower half blocks
+    HEXFONT_TERM_HALF_BLOCKS,
+
+    // One character cell for 2x4 pixels, with the Braille patterns
+    HEXFONT_TERM_BRAILLE,
+
+    // The pixels themselves, white on a transparent background
+    HEXFONT_TERM_SIXEL,
+
+} hexfont_term_mode;
+
+/**
+ * Show a bitmap, a character or some text on a terminal.
+ * Everything is put together in one buffer which is written to fd at
+ * once, rather than a call for each pixel. Text is broken into lines at
+ * '\n' and spaced as hexfont_render_utf8 draws it.
+ * false is returned when out of memory or if the write fails.
+  */
+const bool hexfont_term_write_bitmap(const hexfont_bitmap * const bitmap, const hexfont_term_mode mode, const int fd);
+const bool hexfont_term_write_character(const hexfont_character * const c, const hexfont_term_mode mode, const int fd);
+const bool hexfont_term_write_utf8(hexfont * const font, const char *text, const hexfont_term_mode mode, const int fd);
+const bool hexfont_list_term_write_utf8(hexfont_list * const fonts, const char *text, const hexfont_term_mode mode, const int fd);
+
+/**
+ * A page of the characters from first on, columns to a row, each row
+ * headed by its first codepoint. Codepoints which aren't in the font
+ * are left blank.
+  */
+const bool hexfont_term_write_overview(hexfont * const font, const uint32_t first, const uint32_t columns, const uint32_t rows, const hexfont_term_mode mode, const int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_TERM_H__
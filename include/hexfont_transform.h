@@ -0,0 +1,100 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_TRANSFORM_H__
+#define __HEXFONT_TRANSFORM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+
+/**
+ * Alternative layouts of a glyph cell, for display drivers which want
+ * something other than rows packed MSB first.
+  */
+typedef enum hexfont_transform {
+    // Pages of 8 rows, one byte per column with the top pixel in bit 0,
+    // as SSD1306 style controllers take them
+    HEXFONT_TRANSFORM_PAGES,
+
+    // Turned clockwise
+    HEXFONT_TRANSFORM_ROTATE_90,
+    HEXFONT_TRANSFORM_ROTATE_180,
+    HEXFONT_TRANSFORM_ROTATE_270,
+
+    // Flipped left to right, and top to bottom
+    HEXFONT_TRANSFORM_MIRROR_X,
+    HEXFONT_TRANSFORM_MIRROR_Y,
+
+    HEXFONT_TRANSFORM_COUNT
+
+} hexfont_transform;
+
+/**
+ * A glyph in a transformed layout.
+ * width and height are those of the whole glyph cell after the transform,
+ * so a 8x16 glyph turned by 90 degrees is 16x8. Pages hold
+ * (height + 7) / 8 pages of width bytes, every other layout holds height
+ * rows of stride bytes packed MSB first, like a glyph.
+  */
+typedef struct hexfont_transformed {
+    const uint8_t *data;
+    size_t len;
+    size_t stride;
+    uint16_t width;
+    uint16_t height;
+
+} hexfont_transformed;
+
+// Precomputed layouts for the characters of a font, see below
+typedef struct hexfont_transform_cache hexfont_transform_cache;
+
+/**
+ * Transform one character into out, which must have room for
+ * hexfont_transform_size bytes. result describes the data in out.
+  */
+const size_t hexfont_transform_size(const hexfont_character * const c, const hexfont_transform transform);
+void hexfont_transform_character(const hexfont_character * const c, const hexfont_transform transform, uint8_t * const out, hexfont_transformed * const result);
+
+/**
+ * A cache of one layout for all of the characters of a font.
+ * With precompute every character is transformed now, one after another
+ * in a few large blocks, otherwise each one is transformed the first time
+ * it is asked for. Either way the data stays put until the cache is destroyed, so
+ * it can be handed to DMA. The font must outlive the cache.
+ * Lookups may be made from several threads at once.
+  */
+hexfont_transform_cache * const hexfont_transform_cache_create(hexfont * const font, const hexfont_transform transform, const bool precompute);
+const hexfont_transformed * const hexfont_transform_cache_get(hexfont_transform_cache * const cache, const uint32_t codepoint);
+void hexfont_transform_cache_destroy(hexfont_transform_cache * const cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_TRANSFORM_H__
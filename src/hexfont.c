@@ -25,233 +25,612 @@
 #include <stdio.h>
 #include <string.h>
 #include "hexfont.h"
-
-// Enough for 1234:X...
-#define HEXFONT_MIN_DATA_ITEM_LEN 6
-
-// Codepoints and glyphs are hex strings
-#define HEXFONT_CODEPOINT_NUMBER_BASE 16
-#define HEXFONT_GLYPH_NUMBER_BASE 16
+#include "hexfont_arena.h"
+#include "hexfont_builder.h"
+#include "hexfont_hex.h"
+#include "hexfont_index.h"
+#include "hexfont_source.h"
+#include "hexfont_stats.h"
+#include "hexfont_subset.h"
 
 // Index of ':' character
 #define HEXFONT_DATA_ITEM_SEP_POSITION 4
 
+// Bytes of a file read and fed to the loader at a time
+#define HEXFONT_LOAD_CHUNK_SIZE (16 * 1024)
+
+// Number of characters to make room for before the count is known
+#define HEXFONT_INITIAL_CAPACITY 256
+
+// Slots of the table of distinct glyphs to start with, it is kept at most half full
+#define HEXFONT_SHARED_INITIAL_CAPACITY 1024
+
+// Glyphs dumped with up to this many bytes of text are put together on the stack
+#define HEXFONT_DUMP_STACK_BUFFER 2048
+
 // Default width for non-printable characters
 #define HEXFONT_DEFAULT_NON_PRINTABLE_WIDTH 3
 
+// Columns of a glyph which are looked at to find its ink, widths above this don't fit in a character
+#define HEXFONT_METRICS_MAX_COLUMNS 256
+#define HEXFONT_METRICS_WORD_BITS 64
+
 
 static inline const bool hexfont_character_get_pixel(hexfont_character * const c, const size_t x, const size_t y);
 static inline hexfont_character * const hexfont_get(hexfont * const font, const uint32_t codepoint);
 
-static hexfont * const __hexfont_load_exec(FILE *fp, const uint8_t glyph_height);
-static void __hexfont_parse_glyph(uint8_t **glyph, size_t *glyph_len, char * const glyph_chars, const size_t glyph_chars_len);
-static const uint16_t __hexfont_calculate_width(uint8_t * const glyph, const size_t glyph_len, const uint16_t glyph_height);
-static void __hexfont_add_character(hexfont * const font, uint32_t codepoint, uint8_t * const glyph, const size_t glyph_len, const uint16_t glyph_height);
+static hexfont * const __hexfont_load_file(const char *file, hexfont_loader * const loader);
+static const bool __hexfont_add_character(__hexfont_builder * const builder, uint32_t codepoint, uint8_t * const glyph, const size_t glyph_len);
+static const bool __hexfont_builder_reserve(__hexfont_builder * const builder, const uint32_t capacity);
+static uint8_t * const __hexfont_builder_share(__hexfont_builder * const builder, uint8_t * const glyph, const size_t glyph_len);
+static const bool __hexfont_builder_share_grow(__hexfont_builder * const builder);
+static inline const uint32_t __hexfont_glyph_hash(const uint8_t * const glyph, const size_t glyph_len);
+static int __hexfont_compare_glyphs(const void *a, const void *b);
 
 
 hexfont * const hexfont_load(const char *file, const uint8_t glyph_height) {
-    // Read in the file
-    FILE *fp;
+    return hexfont_load_flags(file, glyph_height, 0);
+}
 
-    fp = fopen(file, "r");
-    if (fp == NULL) {
+hexfont * const hexfont_load_flags(const char *file, const uint8_t glyph_height, const unsigned int flags) {
+    hexfont_loader * const loader = hexfont_loader_create(glyph_height, flags);
+    if (loader == NULL) {
+        return NULL;
+    }
+
+    return __hexfont_load_file(file, loader);
+}
+
+hexfont * const hexfont_load_subset(const char *file, const uint8_t glyph_height, const unsigned int flags, const hexfont_subset * const subset) {
+    hexfont_loader * const loader = hexfont_loader_create(glyph_height, flags);
+    if (loader == NULL) {
         return NULL;
     }
 
-    return __hexfont_load_exec(fp, glyph_height);
+    hexfont_loader_set_subset(loader, subset);
+    return __hexfont_load_file(file, loader);
 }
 
 hexfont * const hexfont_load_data(const char *data, const uint8_t glyph_height) {
-    FILE *fp;
+    hexfont_loader * const loader = hexfont_loader_create(glyph_height, 0);
+    if (loader == NULL) {
+        return NULL;
+    }
 
-    // Treat the data as a file
-    fp = fmemopen((char *)data, strlen(data), "r");
-    if (fp == NULL) {
+    // Lines are parsed where they are, the data isn't copied
+    if (!hexfont_loader_feed(loader, data, strlen(data))) {
+        hexfont_loader_destroy(loader);
         return NULL;
     }
 
-    return __hexfont_load_exec(fp, glyph_height);
+    return hexfont_loader_finish(loader);
 }
 
 void hexfont_destroy(hexfont * const font) {
-    uint16_t i = 0;
-    for (i=0; i<font->length; i++) {
-        __hexfont_node const * tmp;
-        __hexfont_node const * iter = font->buckets[i];
-
-        while (iter) {
-            tmp = iter;
-            iter = iter->next;
+    // Nothing of an embedded font was allocated
+    if (font->embedded) {
+        return;
+    }
 
-            free(tmp->value->glyph);
-            free((hexfont_character *)tmp->value);
-            free((__hexfont_node *)tmp);
-        }
+    if (font->source) {
+        // Sources own the metrics table as well
+        font->source->destroy(font->source);
     }
-    free(font->buckets);
+    else {
+        free(font->metrics);
+    }
+
+    // Glyphs and the lookup table are owned by the arena
+    __hexfont_arena_destroy(font->arena);
+    free(font->characters);
+    free(font->counters);
     free(font);
 }
 
 void hexfont_dump_character(hexfont_character * const c, FILE *fp) {
+    // The whole glyph is put together and written at once, a call for
+    // each pixel is slow enough to notice over a whole font
+    const size_t line_len = (size_t)c->width * 2 + 1;
+    const size_t len = line_len * c->height;
+    char buffer[HEXFONT_DUMP_STACK_BUFFER];
+    char * const out = (len <= sizeof(buffer)) ? buffer : malloc(len);
+    if (out == NULL) {
+        return;
+    }
+
+    char *p = out;
     int16_t by, bx;
     for (by=0; by<c->height; by++) {
         for (bx=0; bx<c->width; bx++) {
-            if (hexfont_character_get_pixel(c, bx, by)) {
-                fprintf(fp, "# ");
-            }
-            else {
-                fprintf(fp, ". ");
-            }
+            *p++ = (hexfont_character_get_pixel(c, bx, by)) ? '#' : '.';
+            *p++ = ' ';
+        }
+        *p++ = '\n';
+    }
+    fwrite(out, 1, len, fp);
+
+    if (out != buffer) {
+        free(out);
+    }
+}
+
+void hexfont_get_memory_stats(hexfont * const font, hexfont_memory_stats * const stats) {
+    memset(stats, 0, sizeof(hexfont_memory_stats));
+    stats->characters = font->length;
+    stats->arena_bytes = __hexfont_arena_size(font->arena);
+    if (font->source && font->source->stats) {
+        font->source->stats(font, stats);
+        return;
+    }
+    if (font->characters == NULL || font->embedded) {
+        return;
+    }
+    stats->table_bytes = (size_t)font->length * (sizeof(hexfont_character) + sizeof(hexfont_metrics));
+
+    // Count each glyph buffer once, however many characters point at it
+    const hexfont_character **sorted = malloc(((size_t)font->length + 1) * sizeof(hexfont_character *));
+    if (sorted == NULL) {
+        return;
+    }
+
+    uint32_t i = 0;
+    for (i=0; i<font->length; i++) {
+        sorted[i] = &font->characters[i];
+        stats->glyph_bytes += font->characters[i].glyph_len;
+    }
+    qsort(sorted, font->length, sizeof(hexfont_character *), __hexfont_compare_glyphs);
+
+    size_t unique_bytes = 0;
+    for (i=0; i<font->length; i++) {
+        if (i == 0 || sorted[i]->glyph != sorted[i - 1]->glyph) {
+            stats->unique_glyphs++;
+            unique_bytes += sorted[i]->glyph_len;
         }
-        fprintf(fp, "\n");
     }
+    stats->saved_bytes = stats->glyph_bytes - unique_bytes;
+
+    free(sorted);
 }
 
 // ----------------------------------------------------------------------------
 // Static helpers
-const uint16_t __hexfont_hash_function(const uint32_t codepoint, const uint16_t N) {
-    return (codepoint % N);
+hexfont_character * const __hexfont_source_get(hexfont * const font, const uint32_t index) {
+    return font->source->get(font, index);
 }
 
-static hexfont * const __hexfont_load_exec(FILE *fp, const uint8_t glyph_height) {
-    char *line = NULL;
-    char *endptr = NULL;
-    size_t len = 0;
+const hexfont_metrics * const __hexfont_metrics_get_slow(hexfont * const font, const uint32_t index) {
+    // Sources fill in the metrics as they decode the character
+    if (font->source == NULL || font->source->get(font, index) == NULL) {
+        return NULL;
+    }
+
+    return &font->metrics[index];
+}
+
+/**
+ * Feed the whole of a file to loader in a single pass, the data needn't be
+ * seekable. The loader is used up either way.
+*/
+static hexfont * const __hexfont_load_file(const char *file, hexfont_loader * const loader) {
+    // Read in the file
+    FILE *fp;
+
+    fp = fopen(file, "r");
+    if (fp == NULL) {
+        hexfont_loader_destroy(loader);
+        return NULL;
+    }
+
+    char chunk[HEXFONT_LOAD_CHUNK_SIZE];
     size_t read;
+    bool ok = true;
+    while (ok && (read = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        ok = hexfont_loader_feed(loader, chunk, read);
+    }
+    ok = ok && !ferror(fp);
 
-    // Count the number of codepoints
-    uint16_t N = 0;
-    while ((read = getline(&line, &len, fp)) != -1) {
-        if (line == NULL || read < HEXFONT_MIN_DATA_ITEM_LEN) {
-            continue;
-        }
-        N++;
+    // Tidy up file pointer
+    fclose(fp);
+
+    if (!ok) {
+        hexfont_loader_destroy(loader);
+        return NULL;
     }
-    free(line);
 
+    return hexfont_loader_finish(loader);
+}
+
+const bool __hexfont_builder_init(__hexfont_builder * const builder, const uint8_t glyph_height) {
     // Allocate memory for the hexfont structure
     hexfont * const font = malloc(sizeof(hexfont));
+    if (font == NULL) {
+        return false;
+    }
 
-    // Allocate memory for the buckets
-    font->length = N;
+    font->directory = NULL;
+    font->pages = NULL;
+    font->directory_length = 0;
+    font->characters = NULL;
+    font->length = 0;
+    font->metrics = NULL;
     font->glyph_height = glyph_height;
-    font->buckets = calloc(N, sizeof(__hexfont_node));
-
-    // Second pass over the data
-    line = NULL;
-    len = 0;
-    fseek(fp, 0, SEEK_SET);
-    while ((read = getline(&line, &len, fp)) != -1) {
-        if (line == NULL || read < HEXFONT_MIN_DATA_ITEM_LEN) {
-            continue;
-        }
+    font->source = NULL;
+    font->embedded = false;
+    font->counters = NULL;
+    font->arena = __hexfont_arena_create();
+    if (font->arena == NULL) {
+        free(font);
+        return false;
+    }
+    font->counters = __hexfont_counters_create();
+
+    builder->font = font;
+    builder->capacity = 0;
+    builder->started = __hexfont_stats_now();
+    builder->subset = NULL;
+    builder->dedup = false;
+    builder->shared = NULL;
+    builder->shared_capacity = 0;
+    builder->shared_length = 0;
+
+    return true;
+}
 
-        // Parse the codepoint number
-        const uint32_t codepoint =
-            (const uint32_t)strtol(line, &endptr, HEXFONT_CODEPOINT_NUMBER_BASE);
+const bool __hexfont_builder_add_line(__hexfont_builder * const builder, const char * const line, const size_t len) {
+    if (len > HEXFONT_BUILDER_MAX_LINE) {
+        return true;
+    }
 
-        // Extract the glyph chars into an array of bytes
-        size_t glyph_len;
-        uint8_t *glyph;
-        __hexfont_parse_glyph(
-                            &glyph,
-                            &glyph_len,
-                            endptr + 1,
-                            strlen(endptr + 1) - 1);
+    const char * const sep = memchr(line, ':', len);
+    if (sep == NULL) {
+        return true;
+    }
 
-        // Create a hexfont_character
-        __hexfont_add_character(font, codepoint, glyph, glyph_len, glyph_height);
+    // Parse the codepoint number
+    uint32_t codepoint;
+    if (!__hexfont_hex_parse_uint32(&codepoint, line, sep - line) ||
+        codepoint > HEXFONT_MAX_CODEPOINT) {
+        return true;
     }
-    free(line);
 
-    // Tidy up file pointer
-    fclose(fp);
+    // Leave out characters which aren't wanted before doing any more work
+    if (builder->subset && !hexfont_subset_contains(builder->subset, codepoint)) {
+        return true;
+    }
 
-    return font;
+    // Ignore the line ending
+    const char * const glyph_chars = sep + 1;
+    size_t glyph_chars_len = (line + len) - glyph_chars;
+    while (glyph_chars_len > 0 &&
+           (glyph_chars[glyph_chars_len - 1] == '\n' ||
+            glyph_chars[glyph_chars_len - 1] == '\r')) {
+        glyph_chars_len--;
+    }
+
+    const size_t glyph_len = glyph_chars_len / HEXFONT_HEX_CHARS_PER_BYTE;
+    if (glyph_len == 0) {
+        return true;
+    }
+
+    // Extract the glyph chars into an array of bytes
+    uint8_t * const glyph = __hexfont_arena_alloc(builder->font->arena, glyph_len, 1);
+    if (glyph == NULL) {
+        return false;
+    }
+
+    // Skip lines which are not valid hex
+    if (!__hexfont_hex_decode(glyph, glyph_chars, glyph_len)) {
+        __hexfont_arena_free_last(builder->font->arena, glyph, glyph_len);
+        return true;
+    }
+
+    // Use the copy of an identical glyph if there already is one
+    uint8_t * const shared = (builder->dedup) ? __hexfont_builder_share(builder, glyph, glyph_len) : glyph;
+    if (shared != glyph) {
+        __hexfont_arena_free_last(builder->font->arena, glyph, glyph_len);
+    }
+
+    // Create a hexfont_character
+    return __hexfont_add_character(builder, codepoint, shared, glyph_len);
 }
 
-/**
- * Convert a character string of hex-digit pairs into an array of bytes
-*/
-static void __hexfont_parse_glyph(uint8_t **glyph, size_t *glyph_len, char * const glyph_chars, const size_t glyph_chars_len) {
-    // Calculate the number of hex pairs in the glyph_chars string
-    *glyph_len = glyph_chars_len / 2;
+const bool __hexfont_builder_append(__hexfont_builder * const builder, __hexfont_builder * const other) {
+    hexfont * const font = builder->font;
+    hexfont * const other_font = other->font;
 
-    // Allocate that many uint8_t items in the glyph array
-    *glyph = calloc(*glyph_len, sizeof(**glyph));
+    bool ok = (UINT32_MAX - font->length > other_font->length);
+    if (ok && font->length + other_font->length > builder->capacity) {
+        ok = __hexfont_builder_reserve(builder, font->length + other_font->length);
+    }
 
-    // Parse each hex pair to an unsigned int
-    size_t i = 0;
-    for (i=0; i<*glyph_len; i++) {
-        sscanf(glyph_chars + 2*i, "%02hhx", (*glyph)+i);
+    if (ok) {
+        // The glyphs stay where they are, their blocks change owner
+        memcpy(&font->characters[font->length],
+               other_font->characters,
+               (size_t)other_font->length * sizeof(hexfont_character));
+        memcpy(&font->metrics[font->length],
+               other_font->metrics,
+               (size_t)other_font->length * sizeof(hexfont_metrics));
+        font->length += other_font->length;
+        __hexfont_arena_merge(font->arena, other_font->arena);
+        other_font->arena = NULL;
     }
+
+    __hexfont_builder_abort(other);
+
+    return ok;
 }
 
-static const uint16_t __hexfont_calculate_width(uint8_t * const glyph, const size_t glyph_len, const uint16_t glyph_height) {
+hexfont * const __hexfont_builder_finish(__hexfont_builder * const builder) {
+    hexfont * const font = builder->font;
+    builder->font = NULL;
+
+    // The glyphs stay shared, the table which found them isn't needed any more
+    free(builder->shared);
+    builder->shared = NULL;
+
+    const uint64_t parsed = __hexfont_stats_now();
+    if (font->counters) {
+        font->counters->parse_ns = parsed - builder->started;
+    }
+
+    // Give back the unused part of the characters and metrics arrays
+    if (font->length > 0) {
+        hexfont_character * const characters =
+            realloc(font->characters, (size_t)font->length * sizeof(hexfont_character));
+        if (characters != NULL) {
+            font->characters = characters;
+        }
+        hexfont_metrics * const metrics =
+            realloc(font->metrics, (size_t)font->length * sizeof(hexfont_metrics));
+        if (metrics != NULL) {
+            font->metrics = metrics;
+        }
+    }
+
+    __hexfont_index index;
+    if (!__hexfont_index_build(
+                            &index,
+                            font->arena,
+                            (font->characters) ? &font->characters[0].codepoint : NULL,
+                            sizeof(hexfont_character),
+                            font->length)) {
+        hexfont_destroy(font);
+        return NULL;
+    }
+
+    font->directory = index.directory;
+    font->pages = index.pages;
+    font->directory_length = index.directory_length;
+
+    if (font->counters) {
+        font->counters->index_ns = __hexfont_stats_now() - parsed;
+    }
+
+    return font;
+}
+
+void __hexfont_builder_abort(__hexfont_builder * const builder) {
+    if (builder->font) {
+        hexfont_destroy(builder->font);
+        builder->font = NULL;
+    }
+
+    free(builder->shared);
+    builder->shared = NULL;
+}
+
+const uint16_t __hexfont_calculate_metrics(hexfont_metrics * const metrics, const uint8_t * const glyph, const size_t glyph_len, const uint16_t glyph_height) {
     // Character width of the glyph, usually 1 or 2
     const size_t glyph_char_width = (glyph_len / glyph_height);
+    const size_t row_bytes = (glyph_char_width > 0) ? glyph_char_width : 1;
+    const size_t rows = glyph_len / row_bytes;
+    const size_t used_bytes = (row_bytes * HEXFONT_BYTE_WIDTH < HEXFONT_METRICS_MAX_COLUMNS) ?
+                                    row_bytes : HEXFONT_METRICS_MAX_COLUMNS / HEXFONT_BYTE_WIDTH;
+
+    // OR all of the rows together, a set bit means some row has ink in
+    // that column. The first column is the top bit of columns[0].
+    uint64_t columns[HEXFONT_METRICS_MAX_COLUMNS / HEXFONT_METRICS_WORD_BITS] = { 0 };
+    int32_t first_row = -1;
+    int32_t last_row = -1;
+
+    size_t row = 0;
+    for (row=0; row<rows; row++) {
+        const uint8_t * const r = glyph + row * row_bytes;
+        uint64_t ink = 0;
+
+        size_t i = 0;
+        for (i=0; i<used_bytes; i++) {
+            const uint64_t bits = (uint64_t)r[i] << (HEXFONT_METRICS_WORD_BITS - HEXFONT_BYTE_WIDTH - (i % 8) * HEXFONT_BYTE_WIDTH);
+            columns[i / 8] |= bits;
+            ink |= bits;
+        }
 
-    // Each byte encodes 8 bits, or 8 'pixels'
-    uint16_t last_on = 0;
-
-    // Loop through each byte in the glyph
-    size_t i = 0;
-    for (i=0; i<glyph_len; i++) {
-        // Loop through each bit in the byte
-        size_t j = 0;
-        for (j=0; j<HEXFONT_BYTE_WIDTH; j++) {
-            // Find the 'x coordinate' represented by the jth bit in the ith byte
-            size_t x = ((i % glyph_char_width) * HEXFONT_BYTE_WIDTH) + j;
-
-            // Check if the bit is set
-            if ((glyph[i] << j) & 0x80) {
-                // Check if this bit is more 'right' than previously seen bits
-                if (x > last_on) {
-                    last_on = x;
-                }
+        if (ink) {
+            if (first_row < 0) {
+                first_row = row;
             }
+            last_row = row;
+        }
+    }
+
+    // Scan whole words for the leftmost and rightmost set column
+    int32_t left = -1;
+    int32_t right = -1;
+    size_t w = 0;
+    for (w=0; w<(used_bytes + 7) / 8; w++) {
+        if (columns[w] == 0) {
+            continue;
         }
+        if (left < 0) {
+            left = w * HEXFONT_METRICS_WORD_BITS + __builtin_clzll(columns[w]);
+        }
+        right = w * HEXFONT_METRICS_WORD_BITS + (HEXFONT_METRICS_WORD_BITS - 1) - __builtin_ctzll(columns[w]);
     }
 
-    // Convert an index to a width
-    last_on += 1;
+    // Adjust, mostly for SPACE character. As it always has been, a glyph
+    // whose only ink is in the first column gets the default width too
+    const uint16_t width = (right > 0) ? right + 1 : HEXFONT_DEFAULT_NON_PRINTABLE_WIDTH;
 
-    // Adjust, mostly for SPACE character
-    if (last_on == 1) {
-        last_on = HEXFONT_DEFAULT_NON_PRINTABLE_WIDTH;
+    if (right >= 0) {
+        metrics->ink_x = left;
+        metrics->ink_y = first_row;
+        metrics->ink_width = right - left + 1;
+        metrics->ink_height = last_row - first_row + 1;
+    }
+    else {
+        metrics->ink_x = 0;
+        metrics->ink_y = 0;
+        metrics->ink_width = 0;
+        metrics->ink_height = 0;
     }
+    metrics->left_bearing = metrics->ink_x;
+    metrics->right_bearing = width - (metrics->ink_x + metrics->ink_width) + HEXFONT_LETTER_SPACING;
+    metrics->advance = width + HEXFONT_LETTER_SPACING;
 
-    return last_on;
+    return width;
 }
 
-static void __hexfont_add_character(hexfont * const font, uint32_t codepoint, uint8_t * const glyph, const size_t glyph_len, const uint16_t glyph_height) {
-    hexfont_character * const character = malloc(sizeof(hexfont_character));
-    __hexfont_node * const node = malloc(sizeof(__hexfont_node));
+static const bool __hexfont_add_character(__hexfont_builder * const builder, uint32_t codepoint, uint8_t * const glyph, const size_t glyph_len) {
+    hexfont * const font = builder->font;
+
+    if (font->length == builder->capacity) {
+        if (builder->capacity > UINT32_MAX / 2) {
+            return false;
+        }
+
+        const uint32_t new_capacity =
+            (builder->capacity > 0) ? builder->capacity * 2 : HEXFONT_INITIAL_CAPACITY;
+        if (!__hexfont_builder_reserve(builder, new_capacity)) {
+            return false;
+        }
+    }
 
     // Initialize a character
+    hexfont_character * const character = &font->characters[font->length++];
     character->codepoint = codepoint;
     character->glyph = glyph;
     character->glyph_len = glyph_len;
-    character->height = glyph_height;
-    character->width = __hexfont_calculate_width(glyph, glyph_len, glyph_height);
+    character->height = font->glyph_height;
+    character->width = __hexfont_calculate_metrics(&font->metrics[font->length - 1], glyph, glyph_len, font->glyph_height);
 
-    // Initialize a node to hold the character
-    node->key = __hexfont_hash_function(codepoint, font->length);
-    node->value = character;
-    node->next = NULL;
+    return true;
+}
+
+// Grow the characters and metrics arrays together
+static const bool __hexfont_builder_reserve(__hexfont_builder * const builder, const uint32_t capacity) {
+    hexfont * const font = builder->font;
 
-    // Add the glyph to the list
-    if (font->buckets[node->key] == NULL) {
-        // First item in the bucket
-        font->buckets[node->key] = node;
+    hexfont_character * const characters =
+        realloc(font->characters, (size_t)capacity * sizeof(hexfont_character));
+    if (characters == NULL) {
+        return false;
     }
-    else {
-        // Append to the end of the bucket
-        __hexfont_node *iter = (__hexfont_node *)font->buckets[node->key];
-        while (iter->next) {
-            iter = iter->next;
+    font->characters = characters;
+
+    hexfont_metrics * const metrics =
+        realloc(font->metrics, (size_t)capacity * sizeof(hexfont_metrics));
+    if (metrics == NULL) {
+        return false;
+    }
+    font->metrics = metrics;
+
+    builder->capacity = capacity;
+    return true;
+}
+
+/**
+ * Find a glyph which is the same as glyph in the table of distinct glyphs.
+ * If there isn't one, glyph is returned and recorded as belonging to the
+ * character which is about to be added.
+*/
+static uint8_t * const __hexfont_builder_share(__hexfont_builder * const builder, uint8_t * const glyph, const size_t glyph_len) {
+    const hexfont * const font = builder->font;
+
+    // Without room in the table the glyph just isn't shared
+    if (builder->shared_length >= builder->shared_capacity / 2 &&
+        !__hexfont_builder_share_grow(builder)) {
+        return glyph;
+    }
+
+    // Each slot holds a character number and the hash of its glyph,
+    // which saves looking at the glyphs of most of the other entries
+    const uint32_t mask = builder->shared_capacity - 1;
+    const uint32_t hash = __hexfont_glyph_hash(glyph, glyph_len);
+    uint32_t slot = hash & mask;
+    while (builder->shared[2*slot] != 0) {
+        if (builder->shared[2*slot + 1] == hash) {
+            const hexfont_character * const c = &font->characters[builder->shared[2*slot] - 1];
+            if (c->glyph_len == glyph_len && memcmp(c->glyph, glyph, glyph_len) == 0) {
+                return c->glyph;
+            }
         }
-        iter->next = node;
+        slot = (slot + 1) & mask;
     }
+
+    builder->shared[2*slot] = font->length + 1;
+    builder->shared[2*slot + 1] = hash;
+    builder->shared_length++;
+
+    return glyph;
 }
 
+// Double the table of distinct glyphs and put the entries back
+static const bool __hexfont_builder_share_grow(__hexfont_builder * const builder) {
+    if (builder->shared_capacity > UINT32_MAX / 2) {
+        return false;
+    }
+
+    const uint32_t capacity =
+        (builder->shared_capacity > 0) ? builder->shared_capacity * 2 : HEXFONT_SHARED_INITIAL_CAPACITY;
+    uint32_t * const shared = calloc((size_t)capacity * 2, sizeof(uint32_t));
+    if (shared == NULL) {
+        return false;
+    }
+
+    const uint32_t mask = capacity - 1;
+    uint32_t i = 0;
+    for (i=0; i<builder->shared_capacity; i++) {
+        if (builder->shared[2*i] == 0) {
+            continue;
+        }
+
+        uint32_t slot = builder->shared[2*i + 1] & mask;
+        while (shared[2*slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        shared[2*slot] = builder->shared[2*i];
+        shared[2*slot + 1] = builder->shared[2*i + 1];
+    }
+
+    free(builder->shared);
+    builder->shared = shared;
+    builder->shared_capacity = capacity;
+
+    return true;
+}
+
+// Multiply and fold a word at a time, glyphs are mostly 16 or 32 bytes
+static inline const uint32_t __hexfont_glyph_hash(const uint8_t * const glyph, const size_t glyph_len) {
+    uint64_t hash = glyph_len;
+    size_t i = 0;
+    for (i=0; i + sizeof(uint64_t)<=glyph_len; i+=sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, glyph + i, sizeof(uint64_t));
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 32;
+    }
+    for (; i<glyph_len; i++) {
+        hash = (hash ^ glyph[i]) * 0x9e3779b97f4a7c15ull;
+    }
+
+    return (uint32_t)(hash ^ (hash >> 29));
+}
+
+// Order characters by the address of their glyph
+static int __hexfont_compare_glyphs(const void *a, const void *b) {
+    const uintptr_t x = (uintptr_t)(*(const hexfont_character * const *)a)->glyph;
+    const uintptr_t y = (uintptr_t)(*(const hexfont_character * const *)b)->glyph;
+
+    return (x > y) - (x < y);
+}
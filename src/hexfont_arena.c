@@ -0,0 +1,148 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "hexfont_arena.h"
+
+static __hexfont_arena_block * const __hexfont_arena_add_block(__hexfont_arena * const arena, const size_t min_size);
+
+
+__hexfont_arena * const __hexfont_arena_create() {
+    __hexfont_arena * const arena = malloc(sizeof(__hexfont_arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    arena->head = NULL;
+    arena->next_block_size = HEXFONT_ARENA_INITIAL_BLOCK_SIZE;
+
+    return arena;
+}
+
+void __hexfont_arena_destroy(__hexfont_arena * const arena) {
+    if (arena == NULL) {
+        return;
+    }
+
+    __hexfont_arena_block *tmp, *iter = arena->head;
+    while (iter) {
+        tmp = iter;
+        iter = iter->next;
+        free(tmp);
+    }
+    free(arena);
+}
+
+/**
+ * Take over all of the blocks of other, which is released
+*/
+void __hexfont_arena_merge(__hexfont_arena * const arena, __hexfont_arena * const other) {
+    if (other == NULL) {
+        return;
+    }
+
+    // Keep the current block at the head so that it is still filled first
+    __hexfont_arena_block *tail = other->head;
+    if (tail) {
+        while (tail->next) {
+            tail = tail->next;
+        }
+        if (arena->head) {
+            tail->next = arena->head->next;
+            arena->head->next = other->head;
+        }
+        else {
+            arena->head = other->head;
+        }
+    }
+    free(other);
+}
+
+void * const __hexfont_arena_alloc(__hexfont_arena * const arena, const size_t size, const size_t alignment) {
+    __hexfont_arena_block *block = arena->head;
+
+    // Try to fit the allocation into the current block
+    if (block) {
+        const size_t offset = (block->used + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= block->size) {
+            block->used = offset + size;
+            return (uint8_t *)(block + 1) + offset;
+        }
+    }
+
+    // Otherwise start a new block, large enough for the allocation
+    block = __hexfont_arena_add_block(arena, size);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->used = size;
+
+    return (uint8_t *)(block + 1);
+}
+
+void __hexfont_arena_free_last(__hexfont_arena * const arena, void * const ptr, const size_t size) {
+    __hexfont_arena_block * const block = arena->head;
+    if (block && (uint8_t *)ptr + size == (uint8_t *)(block + 1) + block->used) {
+        block->used -= size;
+    }
+}
+
+const size_t __hexfont_arena_size(const __hexfont_arena * const arena) {
+    size_t size = 0;
+    if (arena) {
+        const __hexfont_arena_block *iter = arena->head;
+        while (iter) {
+            size += sizeof(__hexfont_arena_block) + iter->size;
+            iter = iter->next;
+        }
+    }
+
+    return size;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static __hexfont_arena_block * const __hexfont_arena_add_block(__hexfont_arena * const arena, const size_t min_size) {
+    size_t size = arena->next_block_size;
+    while (size < min_size) {
+        size *= 2;
+    }
+
+    // The block header is followed directly by the data
+    __hexfont_arena_block * const block = malloc(sizeof(__hexfont_arena_block) + size);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    block->size = size;
+    block->used = 0;
+    block->next = arena->head;
+    arena->head = block;
+
+    // Grow geometrically so that large fonts only need a few blocks
+    if (arena->next_block_size < HEXFONT_ARENA_MAX_BLOCK_SIZE) {
+        arena->next_block_size *= 2;
+    }
+
+    return block;
+}
@@ -0,0 +1,77 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_ARENA_H__
+#define __HEXFONT_ARENA_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of the first block, later blocks double in size up to the maximum
+#define HEXFONT_ARENA_INITIAL_BLOCK_SIZE (64 * 1024)
+#define HEXFONT_ARENA_MAX_BLOCK_SIZE (4 * 1024 * 1024)
+
+// Alignment used for structured allocations from the arena
+#define HEXFONT_ARENA_ALIGNMENT (sizeof(void *))
+
+/**
+ * A block of memory which allocations are carved out of
+  */
+typedef struct __hexfont_arena_block {
+    struct __hexfont_arena_block *next;
+    size_t size;
+    size_t used;
+
+} __hexfont_arena_block;
+
+/**
+ * A bump allocator which owns all of the memory of a loaded font.
+ * Allocations aren't freed one by one, only the most recent can be given
+ * back with __hexfont_arena_free_last, the whole arena is released at once.
+  */
+typedef struct __hexfont_arena {
+    __hexfont_arena_block *head;
+    size_t next_block_size;
+
+} __hexfont_arena;
+
+__hexfont_arena * const __hexfont_arena_create();
+void __hexfont_arena_destroy(__hexfont_arena * const arena);
+void __hexfont_arena_merge(__hexfont_arena * const arena, __hexfont_arena * const other);
+void * const __hexfont_arena_alloc(__hexfont_arena * const arena, const size_t size, const size_t alignment);
+
+// Give back the most recent allocation, if ptr and size are still that
+void __hexfont_arena_free_last(__hexfont_arena * const arena, void * const ptr, const size_t size);
+
+// Bytes held by all of the blocks, used or not
+const size_t __hexfont_arena_size(const __hexfont_arena * const arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_ARENA_H__
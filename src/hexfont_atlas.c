@@ -0,0 +1,217 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_atlas.h"
+#include "hexfont_utf8.h"
+
+// Codepoints of the sample decoded and looked up at a time
+#define HEXFONT_ATLAS_BATCH 64
+
+// The glyphs start on a cache line, the arrays after them are aligned to this
+#define HEXFONT_ATLAS_DATA_ALIGNMENT 64
+#define HEXFONT_ATLAS_ARRAY_ALIGNMENT 8
+
+/**
+ * A character of the font on its way into the atlas, which is sorted by
+ * count then codepoint
+  */
+typedef struct __hexfont_atlas_key {
+    uint32_t count;
+    uint32_t codepoint;
+    uint32_t index;
+
+} __hexfont_atlas_key;
+
+static void __hexfont_atlas_count(hexfont * const font, __hexfont_atlas_key * const keys, const char * const sample, const size_t sample_len);
+static int __hexfont_atlas_compare(const void *a, const void *b);
+static inline const size_t __hexfont_atlas_align(const size_t size, const size_t alignment);
+
+
+hexfont_atlas * const hexfont_atlas_create(hexfont * const font, const hexfont_atlas_order order, const char * const sample, const size_t sample_len) {
+    hexfont_atlas * const atlas = calloc(1, sizeof(hexfont_atlas));
+    __hexfont_atlas_key * const keys = malloc((font->length > 0 ? font->length : 1) * sizeof(__hexfont_atlas_key));
+    if (atlas == NULL || keys == NULL) {
+        free(atlas);
+        free(keys);
+        return NULL;
+    }
+
+    // Characters which a source fails to produce are left out
+    uint32_t length = 0;
+    size_t data_len = 0;
+    uint32_t i = 0;
+    for (i=0; i<font->length; i++) {
+        const hexfont_character * const c = __hexfont_character_at(font, i);
+        if (c) {
+            keys[i].codepoint = c->codepoint;
+            data_len += c->glyph_len;
+            length++;
+        }
+        else {
+            keys[i].codepoint = HEXFONT_ATLAS_NONE;
+        }
+        keys[i].count = 0;
+        keys[i].index = i;
+    }
+
+    if (order == HEXFONT_ATLAS_BY_USAGE && sample) {
+        __hexfont_atlas_count(font, keys, sample, sample_len);
+    }
+    qsort(keys, font->length, sizeof(__hexfont_atlas_key), __hexfont_atlas_compare);
+
+    // The glyphs, then the arrays, in one block
+    const size_t codepoints_at = __hexfont_atlas_align(data_len, HEXFONT_ATLAS_ARRAY_ALIGNMENT);
+    const size_t offsets_at = codepoints_at + __hexfont_atlas_align((size_t)length * sizeof(uint32_t), HEXFONT_ATLAS_ARRAY_ALIGNMENT);
+    const size_t entries_at = offsets_at + __hexfont_atlas_align(((size_t)length + 1) * sizeof(uint32_t), HEXFONT_ATLAS_ARRAY_ALIGNMENT);
+    const size_t widths_at = entries_at + __hexfont_atlas_align((size_t)font->length * sizeof(uint32_t), HEXFONT_ATLAS_ARRAY_ALIGNMENT);
+    const size_t size = widths_at + (size_t)length * sizeof(uint16_t);
+
+    uint8_t *block = NULL;
+    if (posix_memalign((void **)&block, HEXFONT_ATLAS_DATA_ALIGNMENT, size) != 0) {
+        free(atlas);
+        free(keys);
+        return NULL;
+    }
+
+    uint32_t * const codepoints = (uint32_t *)(block + codepoints_at);
+    uint32_t * const offsets = (uint32_t *)(block + offsets_at);
+    uint32_t * const entries = (uint32_t *)(block + entries_at);
+    uint16_t * const widths = (uint16_t *)(block + widths_at);
+
+    for (i=0; i<font->length; i++) {
+        entries[i] = HEXFONT_ATLAS_NONE;
+    }
+
+    // Missing characters were sorted to the end
+    size_t offset = 0;
+    for (i=0; i<length; i++) {
+        const hexfont_character * const c = __hexfont_character_at(font, keys[i].index);
+        memcpy(block + offset, c->glyph, c->glyph_len);
+        codepoints[i] = c->codepoint;
+        widths[i] = c->width;
+        offsets[i] = offset;
+        entries[keys[i].index] = i;
+        offset += c->glyph_len;
+    }
+    offsets[length] = offset;
+    free(keys);
+
+    atlas->length = length;
+    atlas->glyph_height = font->glyph_height;
+    atlas->codepoints = codepoints;
+    atlas->widths = widths;
+    atlas->offsets = offsets;
+    atlas->data = block;
+    atlas->data_len = data_len;
+    atlas->font = font;
+    atlas->entries = entries;
+
+    return atlas;
+}
+
+void hexfont_atlas_destroy(hexfont_atlas * const atlas) {
+    if (atlas == NULL) {
+        return;
+    }
+
+    // The arrays are part of the same block as the glyphs
+    free((void *)atlas->data);
+    free(atlas);
+}
+
+const size_t hexfont_atlas_find_utf8(const hexfont_atlas * const atlas, const char * const text, const size_t len, uint32_t * const entries, uint32_t * const codepoints, const size_t max, size_t * const consumed) {
+    uint32_t chunk[HEXFONT_ATLAS_BATCH];
+    uint32_t numbers[HEXFONT_ATLAS_BATCH];
+    const uint32_t * const font_entries = atlas->entries;
+    const uint32_t * const offsets = atlas->offsets;
+    size_t count = 0;
+    size_t used = 0;
+
+    while (count < max && used < len) {
+        const size_t want = (max - count < HEXFONT_ATLAS_BATCH) ? max - count : HEXFONT_ATLAS_BATCH;
+        size_t chunk_used;
+        const size_t n = __hexfont_utf8_decode_batch(text + used, len - used, chunk, want, &chunk_used);
+        __hexfont_find_batch(atlas->font, chunk, numbers, n);
+
+        size_t i = 0;
+        for (i=0; i<n; i++) {
+            const uint32_t entry = (numbers[i]) ? font_entries[numbers[i] - 1] : HEXFONT_ATLAS_NONE;
+            if (entry != HEXFONT_ATLAS_NONE) {
+                __builtin_prefetch(atlas->data + offsets[entry]);
+            }
+            entries[count + i] = entry;
+        }
+        if (codepoints) {
+            memcpy(&codepoints[count], chunk, n * sizeof(uint32_t));
+        }
+
+        count += n;
+        used += chunk_used;
+    }
+
+    *consumed = used;
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static void __hexfont_atlas_count(hexfont * const font, __hexfont_atlas_key * const keys, const char * const sample, const size_t sample_len) {
+    uint32_t chunk[HEXFONT_ATLAS_BATCH];
+    uint32_t numbers[HEXFONT_ATLAS_BATCH];
+    size_t used = 0;
+
+    while (used < sample_len) {
+        size_t chunk_used;
+        const size_t n = __hexfont_utf8_decode_batch(sample + used, sample_len - used, chunk, HEXFONT_ATLAS_BATCH, &chunk_used);
+        __hexfont_find_batch(font, chunk, numbers, n);
+
+        size_t i = 0;
+        for (i=0; i<n; i++) {
+            if (numbers[i] && keys[numbers[i] - 1].codepoint != HEXFONT_ATLAS_NONE) {
+                keys[numbers[i] - 1].count++;
+            }
+        }
+        used += chunk_used;
+    }
+}
+
+static int __hexfont_atlas_compare(const void *a, const void *b) {
+    const __hexfont_atlas_key * const ka = a;
+    const __hexfont_atlas_key * const kb = b;
+
+    if (ka->count != kb->count) {
+        return (ka->count > kb->count) ? -1 : 1;
+    }
+    if (ka->codepoint != kb->codepoint) {
+        return (ka->codepoint < kb->codepoint) ? -1 : 1;
+    }
+    return 0;
+}
+
+static inline const size_t __hexfont_atlas_align(const size_t size, const size_t alignment) {
+    return (size + alignment - 1) & ~(alignment - 1);
+}
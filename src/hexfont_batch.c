@@ -0,0 +1,97 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_utf8.h"
+
+// Codepoints decoded and looked up at a time
+#define HEXFONT_BATCH_SIZE 64
+
+
+const size_t hexfont_get_utf8_batch(hexfont * const font, const char * const text, const size_t len, hexfont_character ** const out, uint32_t * const codepoints, const size_t max, size_t * const consumed) {
+    uint32_t chunk[HEXFONT_BATCH_SIZE];
+    uint32_t numbers[HEXFONT_BATCH_SIZE];
+    size_t count = 0;
+    size_t used = 0;
+
+    while (count < max && used < len) {
+        const size_t want = (max - count < HEXFONT_BATCH_SIZE) ? max - count : HEXFONT_BATCH_SIZE;
+        size_t chunk_used;
+        const size_t n = __hexfont_utf8_decode_batch(text + used, len - used, chunk, want, &chunk_used);
+        __hexfont_find_batch(font, chunk, numbers, n);
+
+        size_t i = 0;
+        if (font->source == NULL) {
+            // The caller will want the glyphs once the whole batch is
+            // done, so start fetching them now
+            hexfont_character * const characters = font->characters;
+            for (i=0; i<n; i++) {
+                hexfont_character * const c = (numbers[i]) ? &characters[numbers[i] - 1] : NULL;
+                if (c) {
+                    __builtin_prefetch(c->glyph);
+                }
+                out[count + i] = c;
+            }
+        }
+        else {
+            for (i=0; i<n; i++) {
+                out[count + i] = (numbers[i]) ? __hexfont_source_get(font, numbers[i] - 1) : NULL;
+            }
+        }
+        if (codepoints) {
+            memcpy(&codepoints[count], chunk, n * sizeof(uint32_t));
+        }
+
+        count += n;
+        used += chunk_used;
+    }
+
+    *consumed = used;
+    return count;
+}
+
+void __hexfont_find_batch(hexfont * const font, const uint32_t * const codepoints, uint32_t * const numbers, const size_t count) {
+    // The table is read through locals, as the stores to numbers could
+    // otherwise be taken to change it and every load would be repeated
+    const uint32_t * const directory = font->directory;
+    const uint32_t * const pages = font->pages;
+    const uint32_t directory_length = font->directory_length;
+
+    size_t i = 0;
+    for (i=0; i<count; i++) {
+        const uint32_t block = codepoints[i] >> HEXFONT_PAGE_BITS;
+        numbers[i] = (block < directory_length) ?
+            pages[((size_t)directory[block] << HEXFONT_PAGE_BITS) | (codepoints[i] & HEXFONT_PAGE_MASK)] : 0;
+    }
+
+#ifdef HEXFONT_STATS
+    size_t misses = 0;
+    for (i=0; i<count; i++) {
+        misses += (numbers[i] == 0);
+    }
+    __HEXFONT_ADD(font, lookups, count);
+    __HEXFONT_ADD(font, misses, misses);
+#endif
+}
@@ -0,0 +1,451 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hexfont.h"
+#include "hexfont_arena.h"
+#include "hexfont_index.h"
+#include "hexfont_source.h"
+#include "hexfont_stats.h"
+
+// Identifies a compiled font file
+#define HEXFONT_BINARY_MAGIC "HEXFONT\0"
+#define HEXFONT_BINARY_MAGIC_LEN 8
+#define HEXFONT_BINARY_VERSION 3
+
+// Written in native byte order, a file from a different endian machine won't match
+#define HEXFONT_BINARY_BYTE_ORDER 0x01020304
+
+// Sections are padded so that the uint32_t tables can be read in place
+#define HEXFONT_BINARY_ALIGNMENT 8
+
+/**
+ * File layout, each section starts on a HEXFONT_BINARY_ALIGNMENT boundary:
+ *   header
+ *   directory      uint32_t[directory_length], see hexfont_get
+ *   pages          uint32_t[page_count * HEXFONT_PAGE_SIZE]
+ *   codepoints     uint32_t[length], sorted ascending, unique
+ *   glyph_offsets  uint32_t[length + 1], offsets into the glyph blob
+ *   widths         uint8_t[length]
+ *   metrics        hexfont_metrics[length]
+ *   glyphs         all glyph bytes, back to back
+  */
+typedef struct __hexfont_binary_header {
+    char magic[HEXFONT_BINARY_MAGIC_LEN];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t length;
+    uint32_t glyph_height;
+    uint32_t directory_length;
+    uint32_t page_count;
+    uint64_t directory_offset;
+    uint64_t pages_offset;
+    uint64_t codepoints_offset;
+    uint64_t glyph_offsets_offset;
+    uint64_t widths_offset;
+    uint64_t metrics_offset;
+    uint64_t glyphs_offset;
+    uint64_t glyphs_size;
+    uint64_t file_size;
+
+} __hexfont_binary_header;
+
+/**
+ * A font file mapped into memory.
+ * Characters are materialized into slots on first use, under the lock,
+ * and published once they are complete. The glyphs themselves point
+ * into the mapping.
+  */
+typedef struct __hexfont_binary_source {
+    __hexfont_source source;
+    void *mapping;
+    size_t mapping_size;
+    const uint32_t *codepoints;
+    const uint32_t *glyph_offsets;
+    const uint8_t *widths;
+    const uint8_t *glyphs;
+    uint8_t glyph_height;
+    hexfont_character *slots;
+    pthread_mutex_t lock;
+
+} __hexfont_binary_source;
+
+static hexfont_character * const __hexfont_binary_get(hexfont * const font, const uint32_t index);
+static void __hexfont_binary_destroy(__hexfont_source * const source);
+static uint32_t * const __hexfont_binary_collect(hexfont * const font, uint32_t * const length);
+static const uint64_t __hexfont_binary_section(uint64_t * const offset, const uint64_t size);
+static const bool __hexfont_binary_seek(FILE *fp, uint64_t * const offset, const uint64_t target);
+static const bool __hexfont_binary_check_section(const __hexfont_binary_header * const header, const uint64_t offset, const uint64_t size);
+static const bool __hexfont_binary_check_index(const __hexfont_binary_header * const header, const uint8_t * const base);
+static const bool __hexfont_binary_check_glyphs(const __hexfont_binary_header * const header, const uint8_t * const base);
+
+
+const bool hexfont_save_binary(hexfont * const font, const char *file) {
+    // The lookup table is rebuilt over the sorted codepoints
+    uint32_t length;
+    uint32_t *codepoints = __hexfont_binary_collect(font, &length);
+    if (codepoints == NULL) {
+        return false;
+    }
+
+    // Characters are looked up again each time they are needed, those
+    // of a compact font only last until the next lookup
+    uint32_t *glyph_offsets = malloc(((size_t)length + 1) * sizeof(uint32_t));
+    uint8_t *widths = malloc((size_t)length + 1);
+    hexfont_metrics *metrics = malloc(((size_t)length + 1) * sizeof(hexfont_metrics));
+    __hexfont_arena * const arena = __hexfont_arena_create();
+    FILE *fp = NULL;
+    bool ok = (codepoints && glyph_offsets && widths && metrics && arena);
+
+    __hexfont_binary_header header;
+    memset(&header, 0, sizeof(header));
+
+    uint32_t i = 0;
+    for (i=0; ok && i<length; i++) {
+        const hexfont_character * const c = hexfont_get(font, codepoints[i]);
+        glyph_offsets[i] = header.glyphs_size;
+        widths[i] = c->width;
+        metrics[i] = *hexfont_get_metrics(font, codepoints[i]);
+        header.glyphs_size += c->glyph_len;
+    }
+    ok = ok && header.glyphs_size <= UINT32_MAX;
+    if (ok) {
+        glyph_offsets[length] = header.glyphs_size;
+    }
+
+    __hexfont_index index;
+    ok = ok && __hexfont_index_build(&index, arena, codepoints, sizeof(uint32_t), length);
+
+    if (ok) {
+        // Work out where each section goes
+        memcpy(header.magic, HEXFONT_BINARY_MAGIC, HEXFONT_BINARY_MAGIC_LEN);
+        header.version = HEXFONT_BINARY_VERSION;
+        header.byte_order = HEXFONT_BINARY_BYTE_ORDER;
+        header.length = length;
+        header.glyph_height = font->glyph_height;
+        header.directory_length = index.directory_length;
+        header.page_count = index.page_count;
+
+        uint64_t offset = sizeof(header);
+        header.directory_offset = __hexfont_binary_section(&offset, (uint64_t)index.directory_length * sizeof(uint32_t));
+        header.pages_offset = __hexfont_binary_section(&offset, (uint64_t)index.page_count * HEXFONT_PAGE_SIZE * sizeof(uint32_t));
+        header.codepoints_offset = __hexfont_binary_section(&offset, (uint64_t)length * sizeof(uint32_t));
+        header.glyph_offsets_offset = __hexfont_binary_section(&offset, ((uint64_t)length + 1) * sizeof(uint32_t));
+        header.widths_offset = __hexfont_binary_section(&offset, length);
+        header.metrics_offset = __hexfont_binary_section(&offset, (uint64_t)length * sizeof(hexfont_metrics));
+        header.glyphs_offset = __hexfont_binary_section(&offset, header.glyphs_size);
+        header.file_size = offset;
+
+        fp = fopen(file, "wb");
+        ok = (fp != NULL);
+    }
+
+    uint64_t offset = 0;
+    ok = ok && fwrite(&header, sizeof(header), 1, fp) == 1;
+    offset += sizeof(header);
+
+    ok = ok && __hexfont_binary_seek(fp, &offset, header.directory_offset) &&
+        fwrite(index.directory, sizeof(uint32_t), index.directory_length, fp) == index.directory_length;
+    offset += (uint64_t)index.directory_length * sizeof(uint32_t);
+
+    ok = ok && __hexfont_binary_seek(fp, &offset, header.pages_offset) &&
+        fwrite(index.pages, sizeof(uint32_t) * HEXFONT_PAGE_SIZE, index.page_count, fp) == index.page_count;
+    offset += (uint64_t)index.page_count * HEXFONT_PAGE_SIZE * sizeof(uint32_t);
+
+    ok = ok && __hexfont_binary_seek(fp, &offset, header.codepoints_offset) &&
+        fwrite(codepoints, sizeof(uint32_t), length, fp) == length;
+    offset += (uint64_t)length * sizeof(uint32_t);
+
+    ok = ok && __hexfont_binary_seek(fp, &offset, header.glyph_offsets_offset) &&
+        fwrite(glyph_offsets, sizeof(uint32_t), length + 1, fp) == length + 1;
+    offset += ((uint64_t)length + 1) * sizeof(uint32_t);
+
+    ok = ok && __hexfont_binary_seek(fp, &offset, header.widths_offset) &&
+        fwrite(widths, 1, length, fp) == length;
+    offset += length;
+
+    ok = ok && __hexfont_binary_seek(fp, &offset, header.metrics_offset) &&
+        fwrite(metrics, sizeof(hexfont_metrics), length, fp) == length;
+    offset += (uint64_t)length * sizeof(hexfont_metrics);
+
+    ok = ok && __hexfont_binary_seek(fp, &offset, header.glyphs_offset);
+    for (i=0; ok && i<length; i++) {
+        const hexfont_character * const c = hexfont_get(font, codepoints[i]);
+        ok = fwrite(c->glyph, 1, c->glyph_len, fp) == c->glyph_len;
+    }
+
+    if (fp != NULL && fclose(fp) != 0) {
+        ok = false;
+    }
+    __hexfont_arena_destroy(arena);
+    free(metrics);
+    free(widths);
+    free(glyph_offsets);
+    free(codepoints);
+
+    return ok;
+}
+
+hexfont * const hexfont_load_binary(const char *file) {
+    const uint64_t started = __hexfont_stats_now();
+    const int fd = open(file, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(__hexfont_binary_header)) {
+        close(fd);
+        return NULL;
+    }
+
+    // Pages are shared with every other process which maps the same file
+    void * const mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    // Check that the header describes a file we can use
+    const __hexfont_binary_header * const header = mapping;
+    const uint64_t length = header->length;
+    if (memcmp(header->magic, HEXFONT_BINARY_MAGIC, HEXFONT_BINARY_MAGIC_LEN) != 0 ||
+        header->version != HEXFONT_BINARY_VERSION ||
+        header->byte_order != HEXFONT_BINARY_BYTE_ORDER ||
+        header->file_size != (uint64_t)st.st_size ||
+        header->page_count == 0 ||
+        !__hexfont_binary_check_section(header, header->directory_offset, (uint64_t)header->directory_length * sizeof(uint32_t)) ||
+        !__hexfont_binary_check_section(header, header->pages_offset, (uint64_t)header->page_count * HEXFONT_PAGE_SIZE * sizeof(uint32_t)) ||
+        !__hexfont_binary_check_section(header, header->codepoints_offset, length * sizeof(uint32_t)) ||
+        !__hexfont_binary_check_section(header, header->glyph_offsets_offset, (length + 1) * sizeof(uint32_t)) ||
+        !__hexfont_binary_check_section(header, header->widths_offset, length) ||
+        !__hexfont_binary_check_section(header, header->metrics_offset, length * sizeof(hexfont_metrics)) ||
+        !__hexfont_binary_check_section(header, header->glyphs_offset, header->glyphs_size) ||
+        !__hexfont_binary_check_index(header, mapping) ||
+        !__hexfont_binary_check_glyphs(header, mapping)) {
+        munmap(mapping, st.st_size);
+        return NULL;
+    }
+
+    hexfont * const font = malloc(sizeof(hexfont));
+    __hexfont_binary_source * const binary = malloc(sizeof(__hexfont_binary_source));
+
+    // Slots are zeroed pages until a character is first used
+    hexfont_character * const slots = calloc(length > 0 ? length : 1, sizeof(hexfont_character));
+    if (font == NULL || binary == NULL || slots == NULL) {
+        free(font);
+        free(binary);
+        free(slots);
+        munmap(mapping, st.st_size);
+        return NULL;
+    }
+
+    const uint8_t * const base = mapping;
+    binary->source.get = __hexfont_binary_get;
+    binary->source.destroy = __hexfont_binary_destroy;
+    binary->source.stats = NULL;
+    binary->mapping = mapping;
+    binary->mapping_size = st.st_size;
+    binary->codepoints = (const uint32_t *)(base + header->codepoints_offset);
+    binary->glyph_offsets = (const uint32_t *)(base + header->glyph_offsets_offset);
+    binary->widths = base + header->widths_offset;
+    binary->glyphs = base + header->glyphs_offset;
+    binary->glyph_height = header->glyph_height;
+    binary->slots = slots;
+    pthread_mutex_init(&binary->lock, NULL);
+
+    // The lookup table is used straight from the mapping
+    font->directory = (const uint32_t *)(base + header->directory_offset);
+    font->pages = (const uint32_t *)(base + header->pages_offset);
+    font->directory_length = header->directory_length;
+    font->characters = NULL;
+    font->length = header->length;
+    font->metrics = (hexfont_metrics *)(base + header->metrics_offset);
+    font->glyph_height = header->glyph_height;
+    font->arena = NULL;
+    font->source = &binary->source;
+    font->embedded = false;
+
+    // There is nothing to parse, only the header, lookup table and glyphs to check
+    font->counters = __hexfont_counters_create();
+    if (font->counters) {
+        font->counters->parse_ns = __hexfont_stats_now() - started;
+    }
+
+    return font;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static hexfont_character * const __hexfont_binary_get(hexfont * const font, const uint32_t index) {
+    __hexfont_binary_source * const binary = (__hexfont_binary_source *)font->source;
+
+    hexfont_character * const c = &binary->slots[index];
+    if (__atomic_load_n(&c->glyph, __ATOMIC_ACQUIRE) != NULL) {
+        return c;
+    }
+
+    // Fill in the slot the first time, the glyph is published last so
+    // a reader which finds it never sees a partially filled character
+    pthread_mutex_lock(&binary->lock);
+
+    // Another thread may have got here first
+    if (c->glyph == NULL) {
+        c->codepoint = binary->codepoints[index];
+        c->glyph_len = binary->glyph_offsets[index + 1] - binary->glyph_offsets[index];
+        c->width = binary->widths[index];
+        c->height = binary->glyph_height;
+        __HEXFONT_COUNT(font, decodes);
+        __atomic_store_n(&c->glyph, (uint8_t *)binary->glyphs + binary->glyph_offsets[index], __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&binary->lock);
+
+    return c;
+}
+
+static void __hexfont_binary_destroy(__hexfont_source * const source) {
+    __hexfont_binary_source * const binary = (__hexfont_binary_source *)source;
+
+    munmap(binary->mapping, binary->mapping_size);
+    pthread_mutex_destroy(&binary->lock);
+    free(binary->slots);
+    free(binary);
+}
+
+/**
+ * Gather the codepoints which hexfont_get finds a character for, in order
+*/
+static uint32_t * const __hexfont_binary_collect(hexfont * const font, uint32_t * const length) {
+    *length = 0;
+    uint32_t * const codepoints = malloc(((size_t)font->length + 1) * sizeof(uint32_t));
+    if (codepoints == NULL) {
+        return NULL;
+    }
+
+    // Walking the lookup table visits each codepoint once, in order
+    uint32_t block = 0;
+    for (block=0; block<font->directory_length; block++) {
+        if (font->directory[block] == 0) {
+            continue;
+        }
+
+        uint32_t i = 0;
+        for (i=0; i<HEXFONT_PAGE_SIZE; i++) {
+            const uint32_t codepoint = (block << HEXFONT_PAGE_BITS) | i;
+            if (hexfont_get(font, codepoint)) {
+                codepoints[(*length)++] = codepoint;
+            }
+        }
+    }
+
+    return codepoints;
+}
+
+static const uint64_t __hexfont_binary_section(uint64_t * const offset, const uint64_t size) {
+    const uint64_t start =
+        (*offset + HEXFONT_BINARY_ALIGNMENT - 1) & ~(uint64_t)(HEXFONT_BINARY_ALIGNMENT - 1);
+
+    *offset = start + size;
+    return start;
+}
+
+// Pad with zeros up to the start of the next section
+static const bool __hexfont_binary_seek(FILE *fp, uint64_t * const offset, const uint64_t target) {
+    static const uint8_t zeros[HEXFONT_BINARY_ALIGNMENT] = { 0 };
+    const size_t pad = target - *offset;
+
+    *offset = target;
+    return fwrite(zeros, 1, pad, fp) == pad;
+}
+
+static const bool __hexfont_binary_check_section(const __hexfont_binary_header * const header, const uint64_t offset, const uint64_t size) {
+    return offset % HEXFONT_BINARY_ALIGNMENT == 0 &&
+           offset <= header->file_size &&
+           size <= header->file_size - offset;
+}
+
+/**
+ * Check that the lookup table only leads to pages and characters which
+ * are in the file, it is used as it is so nothing is checked later
+*/
+static const bool __hexfont_binary_check_index(const __hexfont_binary_header * const header, const uint8_t * const base) {
+    const uint32_t * const directory = (const uint32_t *)(base + header->directory_offset);
+    const uint32_t * const pages = (const uint32_t *)(base + header->pages_offset);
+
+    uint32_t i = 0;
+    for (i=0; i<header->directory_length; i++) {
+        if (directory[i] >= header->page_count) {
+            return false;
+        }
+    }
+
+    const uint64_t page_entries = (uint64_t)header->page_count * HEXFONT_PAGE_SIZE;
+    uint64_t j = 0;
+    for (j=0; j<page_entries; j++) {
+        if (pages[j] > header->length) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Each glyph has to start where the one before ends, and the last end the
+ * blob. Glyphs are whole rows of the glyph height, which has to fit in a
+ * character, and no wider than their rows, as they are drawn without
+ * checking either
+*/
+static const bool __hexfont_binary_check_glyphs(const __hexfont_binary_header * const header, const uint8_t * const base) {
+    const uint32_t * const glyph_offsets = (const uint32_t *)(base + header->glyph_offsets_offset);
+    const uint8_t * const widths = base + header->widths_offset;
+    const uint32_t glyph_height = header->glyph_height;
+
+    if (glyph_height == 0 || glyph_height > UINT8_MAX ||
+        glyph_offsets[0] != 0 || glyph_offsets[header->length] != header->glyphs_size) {
+        return false;
+    }
+
+    uint32_t i = 0;
+    for (i=0; i<header->length; i++) {
+        if (glyph_offsets[i + 1] < glyph_offsets[i]) {
+            return false;
+        }
+
+        const uint32_t glyph_len = glyph_offsets[i + 1] - glyph_offsets[i];
+        if (glyph_len % glyph_height != 0 ||
+            widths[i] > (uint64_t)HEXFONT_BYTE_WIDTH * (glyph_len / glyph_height)) {
+            return false;
+        }
+    }
+
+    return true;
+}
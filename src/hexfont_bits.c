@@ -0,0 +1,370 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_bits.h"
+#include "hexfont_dispatch.h"
+
+#ifdef HEXFONT_BITS_HAVE_X86
+#include <immintrin.h>
+#endif
+
+// Rows handled at once by the SSE2 kernel, two pages
+#define HEXFONT_BITS_SSE2_ROWS 16
+
+typedef void (*__hexfont_bits_to_pages_function)(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height);
+
+static void __hexfont_bits_to_pages_dispatch(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height);
+static inline const uint64_t __hexfont_bits_transpose8(uint64_t x);
+static void __hexfont_bits_spread_row(uint8_t * const out, const uint8_t * const row, const size_t row_bytes, const unsigned int scale);
+
+// Starts out pointing at the dispatcher which replaces it with the best implementation, see hexfont_dispatch.h
+static __hexfont_bits_to_pages_function __hexfont_bits_to_pages_impl = __hexfont_bits_to_pages_dispatch;
+
+const uint8_t __hexfont_bits_reverse[256] = {
+    0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0, 0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0,
+    0x08, 0x88, 0x48, 0xc8, 0x28, 0xa8, 0x68, 0xe8, 0x18, 0x98, 0x58, 0xd8, 0x38, 0xb8, 0x78, 0xf8,
+    0x04, 0x84, 0x44, 0xc4, 0x24, 0xa4, 0x64, 0xe4, 0x14, 0x94, 0x54, 0xd4, 0x34, 0xb4, 0x74, 0xf4,
+    0x0c, 0x8c, 0x4c, 0xcc, 0x2c, 0xac, 0x6c, 0xec, 0x1c, 0x9c, 0x5c, 0xdc, 0x3c, 0xbc, 0x7c, 0xfc,
+    0x02, 0x82, 0x42, 0xc2, 0x22, 0xa2, 0x62, 0xe2, 0x12, 0x92, 0x52, 0xd2, 0x32, 0xb2, 0x72, 0xf2,
+    0x0a, 0x8a, 0x4a, 0xca, 0x2a, 0xaa, 0x6a, 0xea, 0x1a, 0x9a, 0x5a, 0xda, 0x3a, 0xba, 0x7a, 0xfa,
+    0x06, 0x86, 0x46, 0xc6, 0x26, 0xa6, 0x66, 0xe6, 0x16, 0x96, 0x56, 0xd6, 0x36, 0xb6, 0x76, 0xf6,
+    0x0e, 0x8e, 0x4e, 0xce, 0x2e, 0xae, 0x6e, 0xee, 0x1e, 0x9e, 0x5e, 0xde, 0x3e, 0xbe, 0x7e, 0xfe,
+    0x01, 0x81, 0x41, 0xc1, 0x21, 0xa1, 0x61, 0xe1, 0x11, 0x91, 0x51, 0xd1, 0x31, 0xb1, 0x71, 0xf1,
+    0x09, 0x89, 0x49, 0xc9, 0x29, 0xa9, 0x69, 0xe9, 0x19, 0x99, 0x59, 0xd9, 0x39, 0xb9, 0x79, 0xf9,
+    0x05, 0x85, 0x45, 0xc5, 0x25, 0xa5, 0x65, 0xe5, 0x15, 0x95, 0x55, 0xd5, 0x35, 0xb5, 0x75, 0xf5,
+    0x0d, 0x8d, 0x4d, 0xcd, 0x2d, 0xad, 0x6d, 0xed, 0x1d, 0x9d, 0x5d, 0xdd, 0x3d, 0xbd, 0x7d, 0xfd,
+    0x03, 0x83, 0x43, 0xc3, 0x23, 0xa3, 0x63, 0xe3, 0x13, 0x93, 0x53, 0xd3, 0x33, 0xb3, 0x73, 0xf3,
+    0x0b, 0x8b, 0x4b, 0xcb, 0x2b, 0xab, 0x6b, 0xeb, 0x1b, 0x9b, 0x5b, 0xdb, 0x3b, 0xbb, 0x7b, 0xfb,
+    0x07, 0x87, 0x47, 0xc7, 0x27, 0xa7, 0x67, 0xe7, 0x17, 0x97, 0x57, 0xd7, 0x37, 0xb7, 0x77, 0xf7,
+    0x0f, 0x8f, 0x4f, 0xcf, 0x2f, 0xaf, 0x6f, 0xef, 0x1f, 0x9f, 0x5f, 0xdf, 0x3f, 0xbf, 0x7f, 0xff,
+};
+
+
+// Each bit of a byte repeated 2, 3 or 4 times, MSB first
+static const uint16_t __hexfont_bits_spread2[256] = {
+    0x0000, 0x0003, 0x000c, 0x000f, 0x0030, 0x0033, 0x003c, 0x003f,
+    0x00c0, 0x00c3, 0x00cc, 0x00cf, 0x00f0, 0x00f3, 0x00fc, 0x00ff,
+    0x0300, 0x0303, 0x030c, 0x030f, 0x0330, 0x0333, 0x033c, 0x033f,
+    0x03c0, 0x03c3, 0x03cc, 0x03cf, 0x03f0, 0x03f3, 0x03fc, 0x03ff,
+    0x0c00, 0x0c03, 0x0c0c, 0x0c0f, 0x0c30, 0x0c33, 0x0c3c, 0x0c3f,
+    0x0cc0, 0x0cc3, 0x0ccc, 0x0ccf, 0x0cf0, 0x0cf3, 0x0cfc, 0x0cff,
+    0x0f00, 0x0f03, 0x0f0c, 0x0f0f, 0x0f30, 0x0f33, 0x0f3c, 0x0f3f,
+    0x0fc0, 0x0fc3, 0x0fcc, 0x0fcf, 0x0ff0, 0x0ff3, 0x0ffc, 0x0fff,
+    0x3000, 0x3003, 0x300c, 0x300f, 0x3030, 0x3033, 0x303c, 0x303f,
+    0x30c0, 0x30c3, 0x30cc, 0x30cf, 0x30f0, 0x30f3, 0x30fc, 0x30ff,
+    0x3300, 0x3303, 0x330c, 0x330f, 0x3330, 0x3333, 0x333c, 0x333f,
+    0x33c0, 0x33c3, 0x33cc, 0x33cf, 0x33f0, 0x33f3, 0x33fc, 0x33ff,
+    0x3c00, 0x3c03, 0x3c0c, 0x3c0f, 0x3c30, 0x3c33, 0x3c3c, 0x3c3f,
+    0x3cc0, 0x3cc3, 0x3ccc, 0x3ccf, 0x3cf0, 0x3cf3, 0x3cfc, 0x3cff,
+    0x3f00, 0x3f03, 0x3f0c, 0x3f0f, 0x3f30, 0x3f33, 0x3f3c, 0x3f3f,
+    0x3fc0, 0x3fc3, 0x3fcc, 0x3fcf, 0x3ff0, 0x3ff3, 0x3ffc, 0x3fff,
+    0xc000, 0xc003, 0xc00c, 0xc00f, 0xc030, 0xc033, 0xc03c, 0xc03f,
+    0xc0c0, 0xc0c3, 0xc0cc, 0xc0cf, 0xc0f0, 0xc0f3, 0xc0fc, 0xc0ff,
+    0xc300, 0xc303, 0xc30c, 0xc30f, 0xc330, 0xc333, 0xc33c, 0xc33f,
+    0xc3c0, 0xc3c3, 0xc3cc, 0xc3cf, 0xc3f0, 0xc3f3, 0xc3fc, 0xc3ff,
+    0xcc00, 0xcc03, 0xcc0c, 0xcc0f, 0xcc30, 0xcc33, 0xcc3c, 0xcc3f,
+    0xccc0, 0xccc3, 0xcccc, 0xcccf, 0xccf0, 0xccf3, 0xccfc, 0xccff,
+    0xcf00, 0xcf03, 0xcf0c, 0xcf0f, 0xcf30, 0xcf33, 0xcf3c, 0xcf3f,
+    0xcfc0, 0xcfc3, 0xcfcc, 0xcfcf, 0xcff0, 0xcff3, 0xcffc, 0xcfff,
+    0xf000, 0xf003, 0xf00c, 0xf00f, 0xf030, 0xf033, 0xf03c, 0xf03f,
+    0xf0c0, 0xf0c3, 0xf0cc, 0xf0cf, 0xf0f0, 0xf0f3, 0xf0fc, 0xf0ff,
+    0xf300, 0xf303, 0xf30c, 0xf30f, 0xf330, 0xf333, 0xf33c, 0xf33f,
+    0xf3c0, 0xf3c3, 0xf3cc, 0xf3cf, 0xf3f0, 0xf3f3, 0xf3fc, 0xf3ff,
+    0xfc00, 0xfc03, 0xfc0c, 0xfc0f, 0xfc30, 0xfc33, 0xfc3c, 0xfc3f,
+    0xfcc0, 0xfcc3, 0xfccc, 0xfccf, 0xfcf0, 0xfcf3, 0xfcfc, 0xfcff,
+    0xff00, 0xff03, 0xff0c, 0xff0f, 0xff30, 0xff33, 0xff3c, 0xff3f,
+    0xffc0, 0xffc3, 0xffcc, 0xffcf, 0xfff0, 0xfff3, 0xfffc, 0xffff,
+};
+
+static const uint32_t __hexfont_bits_spread3[256] = {
+    0x000000, 0x000007, 0x000038, 0x00003f, 0x0001c0, 0x0001c7, 0x0001f8, 0x0001ff,
+    0x000e00, 0x000e07, 0x000e38, 0x000e3f, 0x000fc0, 0x000fc7, 0x000ff8, 0x000fff,
+    0x007000, 0x007007, 0x007038, 0x00703f, 0x0071c0, 0x0071c7, 0x0071f8, 0x0071ff,
+    0x007e00, 0x007e07, 0x007e38, 0x007e3f, 0x007fc0, 0x007fc7, 0x007ff8, 0x007fff,
+    0x038000, 0x038007, 0x038038, 0x03803f, 0x0381c0, 0x0381c7, 0x0381f8, 0x0381ff,
+    0x038e00, 0x038e07, 0x038e38, 0x038e3f, 0x038fc0, 0x038fc7, 0x038ff8, 0x038fff,
+    0x03f000, 0x03f007, 0x03f038, 0x03f03f, 0x03f1c0, 0x03f1c7, 0x03f1f8, 0x03f1ff,
+    0x03fe00, 0x03fe07, 0x03fe38, 0x03fe3f, 0x03ffc0, 0x03ffc7, 0x03fff8, 0x03ffff,
+    0x1c0000, 0x1c0007, 0x1c0038, 0x1c003f, 0x1c01c0, 0x1c01c7, 0x1c01f8, 0x1c01ff,
+    0x1c0e00, 0x1c0e07, 0x1c0e38, 0x1c0e3f, 0x1c0fc0, 0x1c0fc7, 0x1c0ff8, 0x1c0fff,
+    0x1c7000, 0x1c7007, 0x1c7038, 0x1c703f, 0x1c71c0, 0x1c71c7, 0x1c71f8, 0x1c71ff,
+    0x1c7e00, 0x1c7e07, 0x1c7e38, 0x1c7e3f, 0x1c7fc0, 0x1c7fc7, 0x1c7ff8, 0x1c7fff,
+    0x1f8000, 0x1f8007, 0x1f8038, 0x1f803f, 0x1f81c0, 0x1f81c7, 0x1f81f8, 0x1f81ff,
+    0x1f8e00, 0x1f8e07, 0x1f8e38, 0x1f8e3f, 0x1f8fc0, 0x1f8fc7, 0x1f8ff8, 0x1f8fff,
+    0x1ff000, 0x1ff007, 0x1ff038, 0x1ff03f, 0x1ff1c0, 0x1ff1c7, 0x1ff1f8, 0x1ff1ff,
+    0x1ffe00, 0x1ffe07, 0x1ffe38, 0x1ffe3f, 0x1fffc0, 0x1fffc7, 0x1ffff8, 0x1fffff,
+    0xe00000, 0xe00007, 0xe00038, 0xe0003f, 0xe001c0, 0xe001c7, 0xe001f8, 0xe001ff,
+    0xe00e00, 0xe00e07, 0xe00e38, 0xe00e3f, 0xe00fc0, 0xe00fc7, 0xe00ff8, 0xe00fff,
+    0xe07000, 0xe07007, 0xe07038, 0xe0703f, 0xe071c0, 0xe071c7, 0xe071f8, 0xe071ff,
+    0xe07e00, 0xe07e07, 0xe07e38, 0xe07e3f, 0xe07fc0, 0xe07fc7, 0xe07ff8, 0xe07fff,
+    0xe38000, 0xe38007, 0xe38038, 0xe3803f, 0xe381c0, 0xe381c7, 0xe381f8, 0xe381ff,
+    0xe38e00, 0xe38e07, 0xe38e38, 0xe38e3f, 0xe38fc0, 0xe38fc7, 0xe38ff8, 0xe38fff,
+    0xe3f000, 0xe3f007, 0xe3f038, 0xe3f03f, 0xe3f1c0, 0xe3f1c7, 0xe3f1f8, 0xe3f1ff,
+    0xe3fe00, 0xe3fe07, 0xe3fe38, 0xe3fe3f, 0xe3ffc0, 0xe3ffc7, 0xe3fff8, 0xe3ffff,
+    0xfc0000, 0xfc0007, 0xfc0038, 0xfc003f, 0xfc01c0, 0xfc01c7, 0xfc01f8, 0xfc01ff,
+    0xfc0e00, 0xfc0e07, 0xfc0e38, 0xfc0e3f, 0xfc0fc0, 0xfc0fc7, 0xfc0ff8, 0xfc0fff,
+    0xfc7000, 0xfc7007, 0xfc7038, 0xfc703f, 0xfc71c0, 0xfc71c7, 0xfc71f8, 0xfc71ff,
+    0xfc7e00, 0xfc7e07, 0xfc7e38, 0xfc7e3f, 0xfc7fc0, 0xfc7fc7, 0xfc7ff8, 0xfc7fff,
+    0xff8000, 0xff8007, 0xff8038, 0xff803f, 0xff81c0, 0xff81c7, 0xff81f8, 0xff81ff,
+    0xff8e00, 0xff8e07, 0xff8e38, 0xff8e3f, 0xff8fc0, 0xff8fc7, 0xff8ff8, 0xff8fff,
+    0xfff000, 0xfff007, 0xfff038, 0xfff03f, 0xfff1c0, 0xfff1c7, 0xfff1f8, 0xfff1ff,
+    0xfffe00, 0xfffe07, 0xfffe38, 0xfffe3f, 0xffffc0, 0xffffc7, 0xfffff8, 0xffffff,
+};
+
+static const uint32_t __hexfont_bits_spread4[256] = {
+    0x00000000, 0x0000000f, 0x000000f0, 0x000000ff, 0x00000f00, 0x00000f0f, 0x00000ff0, 0x00000fff,
+    0x0000f000, 0x0000f00f, 0x0000f0f0, 0x0000f0ff, 0x0000ff00, 0x0000ff0f, 0x0000fff0, 0x0000ffff,
+    0x000f0000, 0x000f000f, 0x000f00f0, 0x000f00ff, 0x000f0f00, 0x000f0f0f, 0x000f0ff0, 0x000f0fff,
+    0x000ff000, 0x000ff00f, 0x000ff0f0, 0x000ff0ff, 0x000fff00, 0x000fff0f, 0x000ffff0, 0x000fffff,
+    0x00f00000, 0x00f0000f, 0x00f000f0, 0x00f000ff, 0x00f00f00, 0x00f00f0f, 0x00f00ff0, 0x00f00fff,
+    0x00f0f000, 0x00f0f00f, 0x00f0f0f0, 0x00f0f0ff, 0x00f0ff00, 0x00f0ff0f, 0x00f0fff0, 0x00f0ffff,
+    0x00ff0000, 0x00ff000f, 0x00ff00f0, 0x00ff00ff, 0x00ff0f00, 0x00ff0f0f, 0x00ff0ff0, 0x00ff0fff,
+    0x00fff000, 0x00fff00f, 0x00fff0f0, 0x00fff0ff, 0x00ffff00, 0x00ffff0f, 0x00fffff0, 0x00ffffff,
+    0x0f000000, 0x0f00000f, 0x0f0000f0, 0x0f0000ff, 0x0f000f00, 0x0f000f0f, 0x0f000ff0, 0x0f000fff,
+    0x0f00f000, 0x0f00f00f, 0x0f00f0f0, 0x0f00f0ff, 0x0f00ff00, 0x0f00ff0f, 0x0f00fff0, 0x0f00ffff,
+    0x0f0f0000, 0x0f0f000f, 0x0f0f00f0, 0x0f0f00ff, 0x0f0f0f00, 0x0f0f0f0f, 0x0f0f0ff0, 0x0f0f0fff,
+    0x0f0ff000, 0x0f0ff00f, 0x0f0ff0f0, 0x0f0ff0ff, 0x0f0fff00, 0x0f0fff0f, 0x0f0ffff0, 0x0f0fffff,
+    0x0ff00000, 0x0ff0000f, 0x0ff000f0, 0x0ff000ff, 0x0ff00f00, 0x0ff00f0f, 0x0ff00ff0, 0x0ff00fff,
+    0x0ff0f000, 0x0ff0f00f, 0x0ff0f0f0, 0x0ff0f0ff, 0x0ff0ff00, 0x0ff0ff0f, 0x0ff0fff0, 0x0ff0ffff,
+    0x0fff0000, 0x0fff000f, 0x0fff00f0, 0x0fff00ff, 0x0fff0f00, 0x0fff0f0f, 0x0fff0ff0, 0x0fff0fff,
+    0x0ffff000, 0x0ffff00f, 0x0ffff0f0, 0x0ffff0ff, 0x0fffff00, 0x0fffff0f, 0x0ffffff0, 0x0fffffff,
+    0xf0000000, 0xf000000f, 0xf00000f0, 0xf00000ff, 0xf0000f00, 0xf0000f0f, 0xf0000ff0, 0xf0000fff,
+    0xf000f000, 0xf000f00f, 0xf000f0f0, 0xf000f0ff, 0xf000ff00, 0xf000ff0f, 0xf000fff0, 0xf000ffff,
+    0xf00f0000, 0xf00f000f, 0xf00f00f0, 0xf00f00ff, 0xf00f0f00, 0xf00f0f0f, 0xf00f0ff0, 0xf00f0fff,
+    0xf00ff000, 0xf00ff00f, 0xf00ff0f0, 0xf00ff0ff, 0xf00fff00, 0xf00fff0f, 0xf00ffff0, 0xf00fffff,
+    0xf0f00000, 0xf0f0000f, 0xf0f000f0, 0xf0f000ff, 0xf0f00f00, 0xf0f00f0f, 0xf0f00ff0, 0xf0f00fff,
+    0xf0f0f000, 0xf0f0f00f, 0xf0f0f0f0, 0xf0f0f0ff, 0xf0f0ff00, 0xf0f0ff0f, 0xf0f0fff0, 0xf0f0ffff,
+    0xf0ff0000, 0xf0ff000f, 0xf0ff00f0, 0xf0ff00ff, 0xf0ff0f00, 0xf0ff0f0f, 0xf0ff0ff0, 0xf0ff0fff,
+    0xf0fff000, 0xf0fff00f, 0xf0fff0f0, 0xf0fff0ff, 0xf0ffff00, 0xf0ffff0f, 0xf0fffff0, 0xf0ffffff,
+    0xff000000, 0xff00000f, 0xff0000f0, 0xff0000ff, 0xff000f00, 0xff000f0f, 0xff000ff0, 0xff000fff,
+    0xff00f000, 0xff00f00f, 0xff00f0f0, 0xff00f0ff, 0xff00ff00, 0xff00ff0f, 0xff00fff0, 0xff00ffff,
+    0xff0f0000, 0xff0f000f, 0xff0f00f0, 0xff0f00ff, 0xff0f0f00, 0xff0f0f0f, 0xff0f0ff0, 0xff0f0fff,
+    0xff0ff000, 0xff0ff00f, 0xff0ff0f0, 0xff0ff0ff, 0xff0fff00, 0xff0fff0f, 0xff0ffff0, 0xff0fffff,
+    0xfff00000, 0xfff0000f, 0xfff000f0, 0xfff000ff, 0xfff00f00, 0xfff00f0f, 0xfff00ff0, 0xfff00fff,
+    0xfff0f000, 0xfff0f00f, 0xfff0f0f0, 0xfff0f0ff, 0xfff0ff00, 0xfff0ff0f, 0xfff0fff0, 0xfff0ffff,
+    0xffff0000, 0xffff000f, 0xffff00f0, 0xffff00ff, 0xffff0f00, 0xffff0f0f, 0xffff0ff0, 0xffff0fff,
+    0xfffff000, 0xfffff00f, 0xfffff0f0, 0xfffff0ff, 0xffffff00, 0xffffff0f, 0xfffffff0, 0xffffffff,
+};
+
+
+void __hexfont_bits_to_pages(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height) {
+    __HEXFONT_DISPATCH_LOAD(__hexfont_bits_to_pages_impl)(out, rows, row_bytes, height);
+}
+
+void __hexfont_bits_to_pages_scalar(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height) {
+    const size_t width = row_bytes * 8;
+    const size_t pages = (height + HEXFONT_BITS_PAGE_ROWS - 1) / HEXFONT_BITS_PAGE_ROWS;
+
+    size_t page = 0;
+    for (page=0; page<pages; page++) {
+        const size_t y0 = page * HEXFONT_BITS_PAGE_ROWS;
+        const size_t n = (height - y0 < HEXFONT_BITS_PAGE_ROWS) ? height - y0 : HEXFONT_BITS_PAGE_ROWS;
+
+        size_t bx = 0;
+        for (bx=0; bx<row_bytes; bx++) {
+            // Bottom row in the top byte, so that after the transpose the
+            // top row ends up in bit 0 of each column
+            uint64_t block = 0;
+            size_t r = 0;
+            for (r=0; r<n; r++) {
+                block |= (uint64_t)rows[(y0 + r) * row_bytes + bx] << (8 * r);
+            }
+
+            block = __hexfont_bits_transpose8(block);
+
+            // Column c comes out in byte 7 - c
+            uint8_t * const dst = out + page * width + bx * 8;
+            size_t c = 0;
+            for (c=0; c<8; c++) {
+                dst[c] = (uint8_t)(block >> (8 * (7 - c)));
+            }
+        }
+    }
+}
+
+void __hexfont_bits_scale(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height, const unsigned int scale) {
+    const size_t out_row_bytes = row_bytes * scale;
+
+    // Spread each row once, then copy it down for the rest of the block
+    size_t y = 0;
+    for (y=0; y<height; y++) {
+        uint8_t * const dst = out + y * scale * out_row_bytes;
+        __hexfont_bits_spread_row(dst, rows + y * row_bytes, row_bytes, scale);
+
+        unsigned int k = 0;
+        for (k=1; k<scale; k++) {
+            memcpy(dst + k * out_row_bytes, dst, out_row_bytes);
+        }
+    }
+}
+
+#ifdef HEXFONT_BITS_HAVE_X86
+/**
+ * One byte column of 16 rows goes into a register, then each movemask
+ * picks out the top bit of every row, which is a column of two pages.
+ * Shifting the 64 bit lanes left by one moves the next column into place.
+*/
+__attribute__((target("sse2")))
+void __hexfont_bits_to_pages_sse2(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height) {
+    const size_t width = row_bytes * 8;
+    const size_t pages = (height + HEXFONT_BITS_PAGE_ROWS - 1) / HEXFONT_BITS_PAGE_ROWS;
+    uint8_t column[HEXFONT_BITS_SSE2_ROWS];
+
+    size_t y0 = 0;
+    for (y0=0; y0<height; y0+=HEXFONT_BITS_SSE2_ROWS) {
+        const size_t n = (height - y0 < HEXFONT_BITS_SSE2_ROWS) ? height - y0 : HEXFONT_BITS_SSE2_ROWS;
+        const size_t page = y0 / HEXFONT_BITS_PAGE_ROWS;
+        uint8_t * const dst0 = out + page * width;
+
+        // The second page may be past the end of a glyph with an odd number of pages
+        uint8_t * const dst1 = (page + 1 < pages) ? dst0 + width : NULL;
+
+        size_t bx = 0;
+        for (bx=0; bx<row_bytes; bx++) {
+            __m128i v;
+            if (row_bytes == 1 && n == HEXFONT_BITS_SSE2_ROWS) {
+                v = _mm_loadu_si128((const __m128i *)(rows + y0));
+            }
+            else if (row_bytes == 2 && n == HEXFONT_BITS_SSE2_ROWS) {
+                // Split the interleaved left and right bytes of 16 wide rows
+                const __m128i a = _mm_loadu_si128((const __m128i *)(rows + y0 * 2));
+                const __m128i b = _mm_loadu_si128((const __m128i *)(rows + y0 * 2 + 16));
+                v = (bx == 0) ?
+                    _mm_packus_epi16(_mm_and_si128(a, _mm_set1_epi16(0x00ff)), _mm_and_si128(b, _mm_set1_epi16(0x00ff))) :
+                    _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+            }
+            else {
+                memset(column, 0, sizeof(column));
+                size_t r = 0;
+                for (r=0; r<n; r++) {
+                    column[r] = rows[(y0 + r) * row_bytes + bx];
+                }
+                v = _mm_loadu_si128((const __m128i *)column);
+            }
+
+            size_t c = 0;
+            for (c=0; c<8; c++) {
+                const uint32_t mask = _mm_movemask_epi8(v);
+                dst0[bx * 8 + c] = (uint8_t)mask;
+                if (dst1) {
+                    dst1[bx * 8 + c] = (uint8_t)(mask >> 8);
+                }
+                v = _mm_slli_epi64(v, 1);
+            }
+        }
+    }
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static void __hexfont_bits_to_pages_dispatch(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height) {
+    static const __hexfont_bits_to_pages_function kernels[] = {
+        __hexfont_bits_to_pages_scalar,
+#ifdef HEXFONT_BITS_HAVE_X86
+        __hexfont_bits_to_pages_sse2,
+#endif
+    };
+    const __hexfont_bits_to_pages_function kernel = kernels[__hexfont_dispatch_index(sizeof(kernels) / sizeof(kernels[0]))];
+    __HEXFONT_DISPATCH_STORE(__hexfont_bits_to_pages_impl, kernel);
+
+    kernel(out, rows, row_bytes, height);
+}
+
+/**
+ * Transpose an 8x8 bit matrix held in a word, row 0 in the top byte and
+ * column 0 in the top bit of each byte (Hacker's Delight, 7-3)
+*/
+static inline const uint64_t __hexfont_bits_transpose8(uint64_t x) {
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x = x ^ t ^ (t << 28);
+
+    return x;
+}
+
+static void __hexfont_bits_spread_row(uint8_t * const out, const uint8_t * const row, const size_t row_bytes, const unsigned int scale) {
+    size_t i = 0;
+    switch (scale) {
+        case 1:
+            memcpy(out, row, row_bytes);
+            break;
+
+        case 2:
+            for (i=0; i<row_bytes; i++) {
+                const uint16_t v = __hexfont_bits_spread2[row[i]];
+                out[2*i] = (uint8_t)(v >> 8);
+                out[2*i + 1] = (uint8_t)v;
+            }
+            break;
+
+        case 3:
+            for (i=0; i<row_bytes; i++) {
+                const uint32_t v = __hexfont_bits_spread3[row[i]];
+                out[3*i] = (uint8_t)(v >> 16);
+                out[3*i + 1] = (uint8_t)(v >> 8);
+                out[3*i + 2] = (uint8_t)v;
+            }
+            break;
+
+        case 4:
+            for (i=0; i<row_bytes; i++) {
+                const uint32_t v = __hexfont_bits_spread4[row[i]];
+                out[4*i] = (uint8_t)(v >> 24);
+                out[4*i + 1] = (uint8_t)(v >> 16);
+                out[4*i + 2] = (uint8_t)(v >> 8);
+                out[4*i + 3] = (uint8_t)v;
+            }
+            break;
+
+        default:
+            // Larger scales set whole bytes from a 0 or 0xff per source bit
+            memset(out, 0, row_bytes * scale);
+            for (i=0; i<row_bytes * HEXFONT_BYTE_WIDTH; i++) {
+                if ((row[i / 8] << (i % 8)) & 0x80) {
+                    size_t x = i * scale;
+                    const size_t end = x + scale;
+                    while (x < end && (x % 8) != 0) {
+                        out[x / 8] |= 0x80 >> (x % 8);
+                        x++;
+                    }
+                    while (x + 8 <= end) {
+                        out[x / 8] = 0xff;
+                        x += 8;
+                    }
+                    while (x < end) {
+                        out[x / 8] |= 0x80 >> (x % 8);
+                        x++;
+                    }
+                }
+            }
+            break;
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_BITS_H__
+#define __HEXFONT_BITS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Rows in one page of a column-major glyph
+#define HEXFONT_BITS_PAGE_ROWS 8
+
+// Each byte with its bits in the opposite order
+extern const uint8_t __hexfont_bits_reverse[256];
+
+/**
+ * Convert height rows of row_bytes packed MSB first into pages of 8 rows.
+ * out[page * row_bytes * 8 + x] has bit j set if pixel (x, page * 8 + j)
+ * is set. Rows past height are blank.
+ * The best implementation for the running CPU is selected on first use.
+  */
+void __hexfont_bits_to_pages(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height);
+
+/**
+ * Scale height rows of row_bytes packed MSB first up by a whole factor.
+ * out gets height * scale rows of row_bytes * scale bytes. Factors up to
+ * 4 use a table which spreads a byte at a time.
+  */
+void __hexfont_bits_scale(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height, const unsigned int scale);
+
+// Individual implementations, exposed for benchmarking
+void __hexfont_bits_to_pages_scalar(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height);
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEXFONT_BITS_HAVE_X86 1
+void __hexfont_bits_to_pages_sse2(uint8_t * const out, const uint8_t * const rows, const size_t row_bytes, const size_t height);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_BITS_H__
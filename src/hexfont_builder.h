@@ -0,0 +1,94 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_BUILDER_H__
+#define __HEXFONT_BUILDER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont.h"
+#include "hexfont_subset.h"
+
+// Lines longer than this, with their line ending, can't be a glyph which
+// fits in a character and are skipped by every loader
+#define HEXFONT_BUILDER_MAX_LINE (64 * 1024)
+
+/**
+ * A font which is being loaded.
+ * Lines are added one at a time and the lookup table is built at the end.
+ * With dedup set, glyphs which are the same as one already loaded share
+ * it, shared is an open addressed hash table of the numbers of the
+ * characters holding each distinct glyph, paired with the glyph's hash.
+ * With subset set, lines for any other codepoint are skipped.
+  */
+typedef struct __hexfont_builder {
+    hexfont *font;
+    uint32_t capacity;
+    const hexfont_subset *subset;
+
+    // When loading began, for the timings of HEXFONT_STATS
+    uint64_t started;
+
+    bool dedup;
+    uint32_t *shared;
+    uint32_t shared_capacity;
+    uint32_t shared_length;
+
+} __hexfont_builder;
+
+const bool __hexfont_builder_init(__hexfont_builder * const builder, const uint8_t glyph_height);
+
+/**
+ * Parse one "codepoint:glyph" line of len chars, which need not be NUL
+ * terminated and includes its line ending, if any. Lines which are not
+ * valid or are longer than HEXFONT_BUILDER_MAX_LINE are skipped, false
+ * is only returned when out of memory.
+  */
+const bool __hexfont_builder_add_line(__hexfont_builder * const builder, const char * const line, const size_t len);
+
+/**
+ * Move all of the characters of other onto the end of builder, other is
+ * released whether or not this succeeds
+  */
+const bool __hexfont_builder_append(__hexfont_builder * const builder, __hexfont_builder * const other);
+
+// Build the lookup table and hand over the font, or NULL if out of memory
+hexfont * const __hexfont_builder_finish(__hexfont_builder * const builder);
+void __hexfont_builder_abort(__hexfont_builder * const builder);
+
+/**
+ * Fill in the metrics of a glyph and return its width, which is that of
+ * the rightmost set pixel
+  */
+const uint16_t __hexfont_calculate_metrics(hexfont_metrics * const metrics, const uint8_t * const glyph, const size_t glyph_len, const uint16_t glyph_height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_BUILDER_H__
@@ -0,0 +1,230 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "hexfont_color.h"
+#include "hexfont_dispatch.h"
+
+#ifdef HEXFONT_COLOR_HAVE_X86
+#include <immintrin.h>
+#endif
+
+typedef void (*__hexfont_color_span_function)(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+
+static void __hexfont_color_span_dispatch(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+static inline __attribute__((always_inline)) void __hexfont_color_expand_any(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+static inline __attribute__((always_inline)) void __hexfont_color_expand(uint8_t * const dst, const size_t pixel_bytes, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+#ifdef HEXFONT_COLOR_HAVE_X86
+static inline __attribute__((always_inline, target("sse2"))) void __hexfont_color_expand_128(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+#endif
+static inline __attribute__((always_inline)) void __hexfont_color_store(uint8_t * const dst, const size_t pixel_bytes, const uint32_t pixel);
+
+// Starts out pointing at the dispatcher which replaces it with the best implementation, see hexfont_dispatch.h
+static __hexfont_color_span_function __hexfont_color_span_impl = __hexfont_color_span_dispatch;
+
+
+void __hexfont_color_pen_init(__hexfont_color_pen * const pen, const hexfont_pixel_format format, const hexfont_colors * const colors) {
+    pen->format = format;
+    pen->transparent = colors->transparent;
+
+    switch (format) {
+        case HEXFONT_PIXEL_RGB565:
+            pen->pixel_bytes = 2;
+            pen->foreground = ((colors->foreground >> 8) & 0xf800) |
+                              ((colors->foreground >> 5) & 0x07e0) |
+                              ((colors->foreground >> 3) & 0x001f);
+            pen->background = ((colors->background >> 8) & 0xf800) |
+                              ((colors->background >> 5) & 0x07e0) |
+                              ((colors->background >> 3) & 0x001f);
+            break;
+
+        case HEXFONT_PIXEL_RGB888:
+            pen->pixel_bytes = 3;
+            pen->foreground = colors->foreground & 0xffffff;
+            pen->background = colors->background & 0xffffff;
+            break;
+
+        default:
+            pen->pixel_bytes = 4;
+            pen->foreground = colors->foreground;
+            pen->background = colors->background;
+            break;
+    }
+}
+
+void __hexfont_color_span(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n) {
+    __HEXFONT_DISPATCH_LOAD(__hexfont_color_span_impl)(dst, pen, bits, n);
+}
+
+void __hexfont_color_span_scalar(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n) {
+    __hexfont_color_expand_any(dst, pen, bits, n);
+}
+
+#ifdef HEXFONT_COLOR_HAVE_X86
+__attribute__((target("sse2")))
+void __hexfont_color_span_sse2(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n) {
+    __hexfont_color_expand_128(dst, pen, bits, n);
+}
+
+// As the SSE2 version, 8 pixels of ARGB8888 or 16 of RGB565 at a time
+__attribute__((target("avx2")))
+void __hexfont_color_span_avx2(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n) {
+    int32_t i = 0;
+
+    if (pen->pixel_bytes == 4) {
+        const __m256i lanes = _mm256_set_epi32(1 << 24, 1 << 25, 1 << 26, 1 << 27, 1 << 28, 1 << 29, 1 << 30, (int)0x80000000);
+        const __m256i fg = _mm256_set1_epi32((int)pen->foreground);
+        const __m256i bg = _mm256_set1_epi32((int)pen->background);
+        for (; i + 8 <= n; i += 8) {
+            const __m256i b = _mm256_set1_epi32((int)(bits << i));
+            const __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(b, lanes), lanes);
+            __m256i * const d = (__m256i *)(dst + 4 * i);
+            const __m256i under = (pen->transparent) ? _mm256_loadu_si256(d) : bg;
+            _mm256_storeu_si256(d, _mm256_blendv_epi8(under, fg, mask));
+        }
+    }
+    else if (pen->pixel_bytes == 2) {
+        const __m256i lanes = _mm256_set_epi16(
+            1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 1 << 6, 1 << 7,
+            1 << 8, 1 << 9, 1 << 10, 1 << 11, 1 << 12, 1 << 13, 1 << 14, (short)0x8000);
+        const __m256i fg = _mm256_set1_epi16((short)pen->foreground);
+        const __m256i bg = _mm256_set1_epi16((short)pen->background);
+        for (; i + 16 <= n; i += 16) {
+            const __m256i b = _mm256_set1_epi16((short)((bits << i) >> 16));
+            const __m256i mask = _mm256_cmpeq_epi16(_mm256_and_si256(b, lanes), lanes);
+            __m256i * const d = (__m256i *)(dst + 2 * i);
+            const __m256i under = (pen->transparent) ? _mm256_loadu_si256(d) : bg;
+            _mm256_storeu_si256(d, _mm256_blendv_epi8(under, fg, mask));
+        }
+    }
+
+    // Narrow glyphs and the rest go through the 128 bit code, inlined so
+    // that it is VEX encoded, mixing in legacy SSE code after 256 bit
+    // instructions can cost hundreds of cycles
+    if (i < n) {
+        __hexfont_color_expand_128(dst + i * pen->pixel_bytes, pen, bits << i, n - i);
+    }
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static void __hexfont_color_span_dispatch(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n) {
+    static const __hexfont_color_span_function kernels[] = {
+        __hexfont_color_span_scalar,
+#ifdef HEXFONT_COLOR_HAVE_X86
+        __hexfont_color_span_sse2,
+        __hexfont_color_span_avx2,
+#endif
+    };
+    const __hexfont_color_span_function kernel = kernels[__hexfont_dispatch_index(sizeof(kernels) / sizeof(kernels[0]))];
+    __HEXFONT_DISPATCH_STORE(__hexfont_color_span_impl, kernel);
+
+    kernel(dst, pen, bits, n);
+}
+
+static inline __attribute__((always_inline)) void __hexfont_color_expand_any(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n) {
+    // Constant pixel sizes let the stores be inlined
+    switch (pen->pixel_bytes) {
+        case 2:
+            __hexfont_color_expand(dst, 2, pen, bits, n);
+            break;
+
+        case 3:
+            __hexfont_color_expand(dst, 3, pen, bits, n);
+            break;
+
+        default:
+            __hexfont_color_expand(dst, 4, pen, bits, n);
+            break;
+    }
+}
+
+static inline __attribute__((always_inline)) void __hexfont_color_expand(uint8_t * const dst, const size_t pixel_bytes, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n) {
+    int32_t i = 0;
+    for (i=0; i<n; i++) {
+        if ((bits << i) & 0x80000000) {
+            __hexfont_color_store(dst + i * pixel_bytes, pixel_bytes, pen->foreground);
+        }
+        else if (!pen->transparent) {
+            __hexfont_color_store(dst + i * pixel_bytes, pixel_bytes, pen->background);
+        }
+    }
+}
+
+#ifdef HEXFONT_COLOR_HAVE_X86
+/**
+ * Each lane is compared against the bit of its pixel, so that set pixels
+ * give a lane of all ones, which picks the foreground over whatever is
+ * underneath: the background, or the old pixels when it is transparent.
+ * RGB888 pixels don't fit lanes and are left to the scalar code.
+*/
+static inline __attribute__((always_inline, target("sse2"))) void __hexfont_color_expand_128(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n) {
+    int32_t i = 0;
+
+    if (pen->pixel_bytes == 4) {
+        const __m128i lanes = _mm_set_epi32(1 << 28, 1 << 29, 1 << 30, (int)0x80000000);
+        const __m128i fg = _mm_set1_epi32((int)pen->foreground);
+        const __m128i bg = _mm_set1_epi32((int)pen->background);
+        for (; i + 4 <= n; i += 4) {
+            const __m128i b = _mm_set1_epi32((int)(bits << i));
+            const __m128i mask = _mm_cmpeq_epi32(_mm_and_si128(b, lanes), lanes);
+            __m128i * const d = (__m128i *)(dst + 4 * i);
+            const __m128i under = (pen->transparent) ? _mm_loadu_si128(d) : bg;
+            _mm_storeu_si128(d, _mm_or_si128(_mm_and_si128(mask, fg), _mm_andnot_si128(mask, under)));
+        }
+    }
+    else if (pen->pixel_bytes == 2) {
+        const __m128i lanes = _mm_set_epi16(1 << 8, 1 << 9, 1 << 10, 1 << 11, 1 << 12, 1 << 13, 1 << 14, (short)0x8000);
+        const __m128i fg = _mm_set1_epi16((short)pen->foreground);
+        const __m128i bg = _mm_set1_epi16((short)pen->background);
+        for (; i + 8 <= n; i += 8) {
+            const __m128i b = _mm_set1_epi16((short)((bits << i) >> 16));
+            const __m128i mask = _mm_cmpeq_epi16(_mm_and_si128(b, lanes), lanes);
+            __m128i * const d = (__m128i *)(dst + 2 * i);
+            const __m128i under = (pen->transparent) ? _mm_loadu_si128(d) : bg;
+            _mm_storeu_si128(d, _mm_or_si128(_mm_and_si128(mask, fg), _mm_andnot_si128(mask, under)));
+        }
+    }
+
+    if (i < n) {
+        __hexfont_color_expand_any(dst + i * pen->pixel_bytes, pen, bits << i, n - i);
+    }
+}
+#endif
+
+// Pixels need not be aligned, the stride is up to the caller
+static inline __attribute__((always_inline)) void __hexfont_color_store(uint8_t * const dst, const size_t pixel_bytes, const uint32_t pixel) {
+    if (pixel_bytes == 2) {
+        const uint16_t value = (uint16_t)pixel;
+        memcpy(dst, &value, sizeof(value));
+    }
+    else if (pixel_bytes == 3) {
+        dst[0] = (uint8_t)pixel;
+        dst[1] = (uint8_t)(pixel >> 8);
+        dst[2] = (uint8_t)(pixel >> 16);
+    }
+    else {
+        memcpy(dst, &pixel, sizeof(pixel));
+    }
+}
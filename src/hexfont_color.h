@@ -0,0 +1,73 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_COLOR_H__
+#define __HEXFONT_COLOR_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont_render.h"
+
+// Most pixels expanded by one call of __hexfont_color_span
+#define HEXFONT_COLOR_SPAN_BITS 32
+
+/**
+ * The colors of a hexfont_colors packed into a surface's pixel format
+  */
+typedef struct __hexfont_color_pen {
+    hexfont_pixel_format format;
+    size_t pixel_bytes;
+    uint32_t foreground;
+    uint32_t background;
+    bool transparent;
+
+} __hexfont_color_pen;
+
+void __hexfont_color_pen_init(__hexfont_color_pen * const pen, const hexfont_pixel_format format, const hexfont_colors * const colors);
+
+/**
+ * Write n pixels, 1 to HEXFONT_COLOR_SPAN_BITS of them, to dst. The
+ * pixels are the bits of bits MSB first, set ones are drawn with the
+ * foreground and clear ones with the background unless it is transparent.
+ * The best implementation for the running CPU is selected on first use.
+  */
+void __hexfont_color_span(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+
+// Individual implementations, exposed for benchmarking
+void __hexfont_color_span_scalar(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEXFONT_COLOR_HAVE_X86 1
+void __hexfont_color_span_sse2(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+void __hexfont_color_span_avx2(uint8_t * const dst, const __hexfont_color_pen * const pen, const uint32_t bits, const int32_t n);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_COLOR_H__
@@ -0,0 +1,362 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_arena.h"
+#include "hexfont_index.h"
+#include "hexfont_source.h"
+#include "hexfont_stats.h"
+
+// Largest glyph which is compressed, the size of the per thread buffer
+#define HEXFONT_COMPACT_MAX_GLYPH 256
+
+// Rows are marked in 64 bit masks, taller glyphs are kept as they are
+#define HEXFONT_COMPACT_MAX_ROWS 64
+
+// Glyphs up to this many bytes wide are expanded a whole row at a time
+#define HEXFONT_COMPACT_NARROW_ROW_BYTES 2
+
+// Set in the first byte of a glyph which is kept as it is
+#define HEXFONT_COMPACT_RAW 0x80
+
+/**
+ * A font whose glyphs are packed back to back in the arena.
+ * Each glyph starts with a byte which is HEXFONT_COMPACT_RAW if the glyph
+ * bytes simply follow, or else holds its row bytes. In that case it has
+ * two masks of (height + 7) / 8 bytes, rows which are stored and rows
+ * which are the same as the one above, and then the stored rows.
+ * Rows in neither mask are blank.
+  */
+typedef struct __hexfont_compact_source {
+    __hexfont_source source;
+    const uint8_t *glyphs;
+    uint32_t *offsets;
+    uint32_t *codepoints;
+    uint8_t *widths;
+    hexfont_metrics *metrics;
+    size_t glyph_bytes;
+    size_t stored_bytes;
+
+} __hexfont_compact_source;
+
+static hexfont_character * const __hexfont_compact_get(hexfont * const font, const uint32_t index);
+static void __hexfont_compact_destroy(__hexfont_source * const source);
+static void __hexfont_compact_stats(hexfont * const font, hexfont_memory_stats * const stats);
+static const size_t __hexfont_compact_encode(uint8_t * const out, const hexfont_character * const c);
+static inline __attribute__((always_inline)) void __hexfont_compact_expand(uint8_t *out, const uint8_t *rows, uint64_t stored, uint64_t repeated, const size_t row_bytes, const uint16_t height);
+static inline __attribute__((always_inline)) void __hexfont_compact_expand_narrow(uint8_t *out, const uint8_t *rows, uint64_t stored, uint64_t repeated, const size_t row_bytes, const uint16_t height);
+
+// Where the glyph returned by hexfont_get is decoded, one per thread
+static __thread hexfont_character __hexfont_compact_character;
+static __thread uint8_t __hexfont_compact_buffer[HEXFONT_COMPACT_MAX_GLYPH];
+
+
+hexfont * const hexfont_compact(hexfont * const font) {
+    const uint64_t started = __hexfont_stats_now();
+    hexfont * const compact = malloc(sizeof(hexfont));
+    __hexfont_compact_source * const source = malloc(sizeof(__hexfont_compact_source));
+    if (compact == NULL || source == NULL) {
+        free(compact);
+        free(source);
+        return NULL;
+    }
+
+    const size_t length = font->length;
+    source->source.get = __hexfont_compact_get;
+    source->source.destroy = __hexfont_compact_destroy;
+    source->source.stats = __hexfont_compact_stats;
+    source->glyphs = NULL;
+    source->offsets = malloc((length + 1) * sizeof(uint32_t));
+    source->codepoints = malloc((length + 1) * sizeof(uint32_t));
+    source->widths = malloc(length + 1);
+    source->metrics = malloc((length + 1) * sizeof(hexfont_metrics));
+    source->glyph_bytes = 0;
+    source->stored_bytes = 0;
+
+    compact->directory = NULL;
+    compact->pages = NULL;
+    compact->directory_length = 0;
+    compact->characters = NULL;
+    compact->length = 0;
+    compact->metrics = source->metrics;
+    compact->glyph_height = font->glyph_height;
+    compact->source = &source->source;
+    compact->embedded = false;
+    compact->counters = __hexfont_counters_create();
+    compact->arena = __hexfont_arena_create();
+
+    bool ok = (source->offsets && source->codepoints && source->widths &&
+               source->metrics && compact->arena);
+
+    // Work out how much room the glyphs need first, so that they go in one block
+    size_t size = 0;
+    uint32_t i = 0;
+    for (i=0; ok && i<length; i++) {
+        const hexfont_character * const c = __hexfont_character_at(font, i);
+        if (c != NULL) {
+            size += __hexfont_compact_encode(NULL, c);
+        }
+    }
+    // Narrow glyphs read a row for every line, blank and repeated ones too,
+    // so after the last stored row of the last glyph there is one more
+    uint8_t * const glyphs = (ok) ? __hexfont_arena_alloc(compact->arena, size + HEXFONT_COMPACT_NARROW_ROW_BYTES, 1) : NULL;
+    ok = (glyphs != NULL) && size <= UINT32_MAX;
+
+    // Characters which are hidden by an earlier one with the same
+    // codepoint, or which fail to decode, are left out
+    size_t offset = 0;
+    for (i=0; ok && i<length; i++) {
+        const hexfont_character * const c = __hexfont_character_at(font, i);
+        if (c == NULL || __hexfont_find(font, c->codepoint) != i + 1) {
+            continue;
+        }
+
+        const uint32_t n = compact->length++;
+        source->offsets[n] = offset;
+        source->codepoints[n] = c->codepoint;
+        source->widths[n] = c->width;
+        source->metrics[n] = font->metrics[i];
+        source->glyph_bytes += c->glyph_len;
+        offset += __hexfont_compact_encode(glyphs + offset, c);
+    }
+    if (ok) {
+        source->offsets[compact->length] = offset;
+        source->glyphs = glyphs;
+        source->stored_bytes = offset;
+    }
+
+    __hexfont_index index;
+    ok = ok && __hexfont_index_build(&index, compact->arena, source->codepoints, sizeof(uint32_t), compact->length);
+    if (!ok) {
+        hexfont_destroy(compact);
+        return NULL;
+    }
+
+    compact->directory = index.directory;
+    compact->pages = index.pages;
+    compact->directory_length = index.directory_length;
+
+    // The copy was loaded when font was, and then compacted
+    if (compact->counters) {
+        if (font->counters) {
+            compact->counters->parse_ns = font->counters->parse_ns;
+            compact->counters->index_ns = font->counters->index_ns;
+        }
+        compact->counters->compact_ns = __hexfont_stats_now() - started;
+    }
+
+    return compact;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static hexfont_character * const __hexfont_compact_get(hexfont * const font, const uint32_t index) {
+    const __hexfont_compact_source * const source = (const __hexfont_compact_source *)font->source;
+    const uint8_t * const data = source->glyphs + source->offsets[index];
+    const uint16_t height = font->glyph_height;
+
+    __HEXFONT_COUNT(font, decodes);
+
+    hexfont_character * const c = &__hexfont_compact_character;
+    c->codepoint = source->codepoints[index];
+    c->width = source->widths[index];
+    c->height = height;
+
+    // Raw glyphs can be used where they are
+    if (data[0] == HEXFONT_COMPACT_RAW) {
+        c->glyph = (uint8_t *)data + 1;
+        c->glyph_len = source->offsets[index + 1] - source->offsets[index] - 1;
+        return c;
+    }
+
+    const size_t row_bytes = data[0];
+    c->glyph_len = row_bytes * height;
+
+    const size_t mask_bytes = (height + 7) / 8;
+    uint64_t stored = 0;
+    uint64_t repeated = 0;
+    size_t k = 0;
+    for (k=0; k<mask_bytes; k++) {
+        stored |= (uint64_t)data[1 + k] << (8 * k);
+        repeated |= (uint64_t)data[1 + mask_bytes + k] << (8 * k);
+    }
+
+    // Constant row sizes let the copies be inlined for the usual widths
+    const uint8_t * const rows = data + 1 + 2 * mask_bytes;
+    switch (row_bytes) {
+        case 1:
+            __hexfont_compact_expand_narrow(__hexfont_compact_buffer, rows, stored, repeated, 1, height);
+            break;
+
+        case 2:
+            __hexfont_compact_expand_narrow(__hexfont_compact_buffer, rows, stored, repeated, 2, height);
+            break;
+
+        default:
+            __hexfont_compact_expand(__hexfont_compact_buffer, rows, stored, repeated, row_bytes, height);
+            break;
+    }
+    c->glyph = __hexfont_compact_buffer;
+
+    return c;
+}
+
+static void __hexfont_compact_destroy(__hexfont_source * const source) {
+    __hexfont_compact_source * const compact = (__hexfont_compact_source *)source;
+
+    // The glyphs are in the font's arena
+    free(compact->offsets);
+    free(compact->codepoints);
+    free(compact->widths);
+    free(compact->metrics);
+    free(compact);
+}
+
+static void __hexfont_compact_stats(hexfont * const font, hexfont_memory_stats * const stats) {
+    const __hexfont_compact_source * const source = (const __hexfont_compact_source *)font->source;
+
+    stats->unique_glyphs = font->length;
+    stats->glyph_bytes = source->glyph_bytes;
+    stats->saved_bytes = (source->glyph_bytes > source->stored_bytes) ?
+                            source->glyph_bytes - source->stored_bytes : 0;
+    stats->table_bytes = ((size_t)font->length + 1) * sizeof(uint32_t) +
+                         (size_t)font->length * (sizeof(uint32_t) + sizeof(uint8_t) + sizeof(hexfont_metrics));
+}
+
+/**
+ * Write the compact form of a glyph to out and return its size, or
+ * only return the size if out is NULL
+*/
+static const size_t __hexfont_compact_encode(uint8_t * const out, const hexfont_character * const c) {
+    const size_t row_bytes = c->glyph_len / c->height;
+    const size_t mask_bytes = (c->height + 7) / 8;
+
+    // Sort out which rows need to be stored
+    uint64_t stored = 0;
+    uint64_t repeated = 0;
+    size_t size = 1 + 2 * mask_bytes;
+    size_t y = 0;
+    const bool fits = (c->height <= HEXFONT_COMPACT_MAX_ROWS &&
+                       c->glyph_len <= HEXFONT_COMPACT_MAX_GLYPH &&
+                       c->glyph_len == row_bytes * c->height &&
+                       row_bytes < HEXFONT_COMPACT_RAW);
+    if (fits) {
+        for (y=0; y<c->height; y++) {
+            const uint8_t * const row = c->glyph + y * row_bytes;
+            size_t k = 0;
+            while (k < row_bytes && row[k] == 0) {
+                k++;
+            }
+
+            if (k == row_bytes) {
+                continue;
+            }
+            if (y > 0 && memcmp(row, row - row_bytes, row_bytes) == 0) {
+                repeated |= (uint64_t)1 << y;
+                continue;
+            }
+            stored |= (uint64_t)1 << y;
+            size += row_bytes;
+        }
+    }
+
+    // Keep the glyph as it is when that is no bigger
+    const bool raw = (!fits || size >= 1 + c->glyph_len);
+    if (raw) {
+        size = 1 + c->glyph_len;
+    }
+    if (out == NULL) {
+        return size;
+    }
+
+    if (raw) {
+        out[0] = HEXFONT_COMPACT_RAW;
+        memcpy(out + 1, c->glyph, c->glyph_len);
+        return size;
+    }
+
+    out[0] = row_bytes;
+    size_t k = 0;
+    for (k=0; k<mask_bytes; k++) {
+        out[1 + k] = (uint8_t)(stored >> (8 * k));
+        out[1 + mask_bytes + k] = (uint8_t)(repeated >> (8 * k));
+    }
+
+    uint8_t *dst = out + 1 + 2 * mask_bytes;
+    for (y=0; y<c->height; y++) {
+        if (stored & ((uint64_t)1 << y)) {
+            memcpy(dst, c->glyph + y * row_bytes, row_bytes);
+            dst += row_bytes;
+        }
+    }
+
+    return size;
+}
+
+// Fill in the rows of a glyph from the masks and the stored rows
+static inline __attribute__((always_inline)) void __hexfont_compact_expand(uint8_t *out, const uint8_t *rows, uint64_t stored, uint64_t repeated, const size_t row_bytes, const uint16_t height) {
+    uint16_t y = 0;
+    for (y=0; y<height; y++) {
+        if (stored & 1) {
+            memcpy(out, rows, row_bytes);
+            rows += row_bytes;
+        }
+        else if (repeated & 1) {
+            memcpy(out, out - row_bytes, row_bytes);
+        }
+        else {
+            memset(out, 0, row_bytes);
+        }
+
+        stored >>= 1;
+        repeated >>= 1;
+        out += row_bytes;
+    }
+}
+
+/**
+ * As above for rows of up to HEXFONT_COMPACT_NARROW_ROW_BYTES, choosing
+ * between the stored row, the one above and a blank one without
+ * branching, as the pattern of rows is different for every glyph
+*/
+static inline __attribute__((always_inline)) void __hexfont_compact_expand_narrow(uint8_t *out, const uint8_t *rows, uint64_t stored, uint64_t repeated, const size_t row_bytes, const uint16_t height) {
+    uint16_t row = 0;
+    size_t next = 0;
+    uint16_t y = 0;
+    for (y=0; y<height; y++) {
+        uint16_t value = 0;
+        memcpy(&value, rows + next, row_bytes);
+
+        const uint16_t take = (uint16_t)0 - (uint16_t)(stored & 1);
+        const uint16_t keep = (uint16_t)0 - (uint16_t)(repeated & 1);
+        row = (value & take) | (row & keep & ~take);
+        memcpy(out, &row, row_bytes);
+
+        next += (stored & 1) * row_bytes;
+        stored >>= 1;
+        repeated >>= 1;
+        out += row_bytes;
+    }
+}
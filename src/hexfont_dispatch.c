@@ -0,0 +1,59 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include "hexfont_dispatch.h"
+
+static void __hexfont_dispatch_detect();
+
+// Set once by __hexfont_dispatch_detect
+static pthread_once_t __hexfont_dispatch_once = PTHREAD_ONCE_INIT;
+static __hexfont_dispatch_level __hexfont_dispatch_detected = __HEXFONT_DISPATCH_SCALAR;
+
+
+const __hexfont_dispatch_level __hexfont_dispatch_cpu() {
+    pthread_once(&__hexfont_dispatch_once, __hexfont_dispatch_detect);
+
+    return __hexfont_dispatch_detected;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static void __hexfont_dispatch_detect() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        __hexfont_dispatch_detected = __HEXFONT_DISPATCH_AVX2;
+    }
+#ifdef __x86_64__
+    // Part of x86-64 itself, only a 32 bit CPU may be without it
+    else {
+        __hexfont_dispatch_detected = __HEXFONT_DISPATCH_SSE2;
+    }
+#else
+    else if (__builtin_cpu_supports("sse2")) {
+        __hexfont_dispatch_detected = __HEXFONT_DISPATCH_SSE2;
+    }
+#endif
+#endif
+}
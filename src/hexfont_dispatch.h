@@ -0,0 +1,64 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_DISPATCH_H__
+#define __HEXFONT_DISPATCH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * Kernels which are picked for the CPU the first time they are called.
+ * Each has a pointer which starts out at a dispatcher, which looks up its
+ * kernel for the level of the CPU, stores it and calls it. Threads racing
+ * on the first call all store the same kernel, and the pointer is only
+ * loaded and stored whole with __HEXFONT_DISPATCH_LOAD and _STORE, so a
+ * thread sees either the dispatcher or the kernel.
+  */
+typedef enum __hexfont_dispatch_level {
+    __HEXFONT_DISPATCH_SCALAR,
+    __HEXFONT_DISPATCH_SSE2,
+    __HEXFONT_DISPATCH_AVX2,
+
+} __hexfont_dispatch_level;
+
+#define __HEXFONT_DISPATCH_LOAD(impl) __atomic_load_n(&(impl), __ATOMIC_RELAXED)
+#define __HEXFONT_DISPATCH_STORE(impl, kernel) __atomic_store_n(&(impl), (kernel), __ATOMIC_RELAXED)
+
+// Best level the CPU has, it is only worked out once
+const __hexfont_dispatch_level __hexfont_dispatch_cpu();
+
+// Index of the kernel to use out of count, one per level from scalar up
+static inline const size_t __hexfont_dispatch_index(const size_t count) {
+    const size_t level = __hexfont_dispatch_cpu();
+    return (level < count) ? level : count - 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_DISPATCH_H__
@@ -0,0 +1,209 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hexfont_dispatch.h"
+#include "hexfont_hex.h"
+
+#ifdef HEXFONT_HEX_HAVE_X86
+#include <immintrin.h>
+#endif
+
+// Marks a char which is not a hex digit in the lookup table
+#define HEXFONT_HEX_INVALID 0xff
+
+typedef const bool (*__hexfont_hex_decode_function)(uint8_t * const out, const char * const hex, const size_t out_len);
+
+static const bool __hexfont_hex_decode_dispatch(uint8_t * const out, const char * const hex, const size_t out_len);
+
+// Starts out pointing at the dispatcher which replaces it with the best implementation, see hexfont_dispatch.h
+static __hexfont_hex_decode_function __hexfont_hex_decode_impl = __hexfont_hex_decode_dispatch;
+
+// Value of each hex digit char, anything else is HEXFONT_HEX_INVALID
+#define X HEXFONT_HEX_INVALID
+static const uint8_t __hexfont_hex_table[256] = {
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, X, X, X, X, X, X,
+    X,10,11,12,13,14,15, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X,10,11,12,13,14,15, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+};
+#undef X
+
+
+const bool __hexfont_hex_decode(uint8_t * const out, const char * const hex, const size_t out_len) {
+    return __HEXFONT_DISPATCH_LOAD(__hexfont_hex_decode_impl)(out, hex, out_len);
+}
+
+const bool __hexfont_hex_parse_uint32(uint32_t * const value, const char * const hex, const size_t len) {
+    if (len == 0 || len > 2 * sizeof(uint32_t)) {
+        return false;
+    }
+
+    uint32_t v = 0;
+    uint8_t invalid = 0;
+    size_t i = 0;
+    for (i=0; i<len; i++) {
+        const uint8_t digit = __hexfont_hex_table[(uint8_t)hex[i]];
+        invalid |= digit;
+        v = (v << 4) | (digit & 0x0f);
+    }
+
+    *value = v;
+    return (invalid & 0x80) == 0;
+}
+
+const bool __hexfont_hex_decode_scalar(uint8_t * const out, const char * const hex, const size_t out_len) {
+    const uint8_t * const in = (const uint8_t *)hex;
+
+    // Invalid chars have the top bit set, so accumulate and check once at the end
+    uint8_t invalid = 0;
+    size_t i = 0;
+    for (i=0; i<out_len; i++) {
+        const uint8_t hi = __hexfont_hex_table[in[2*i]];
+        const uint8_t lo = __hexfont_hex_table[in[2*i + 1]];
+        invalid |= hi | lo;
+        out[i] = (uint8_t)((hi << 4) | (lo & 0x0f));
+    }
+
+    return (invalid & 0x80) == 0;
+}
+
+#ifdef HEXFONT_HEX_HAVE_X86
+/**
+ * Convert 16 hex chars to 16 nibble values in 16 bit lanes of (hi << 4 | lo).
+ * The valid mask is cleared in any lane which contained a non hex digit char.
+*/
+__attribute__((target("sse2")))
+static inline __m128i __hexfont_hex_nibbles_sse2(const __m128i chars, __m128i * const valid) {
+    // '0'..'9' map to 0..9
+    const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+
+    // 'a'..'f' and 'A'..'F' map to 0..5
+    const __m128i alpha = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+
+    const __m128i value = _mm_or_si128(
+        _mm_and_si128(digit, is_digit),
+        _mm_and_si128(_mm_add_epi8(alpha, _mm_set1_epi8(10)), is_alpha));
+    *valid = _mm_and_si128(*valid, _mm_or_si128(is_digit, is_alpha));
+
+    // The high nibble comes first in memory, i.e. in the low byte of each 16 bit lane
+    return _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(value, _mm_set1_epi16(0x00ff)), 4),
+        _mm_srli_epi16(value, 8));
+}
+
+__attribute__((target("sse2")))
+const bool __hexfont_hex_decode_sse2(uint8_t * const out, const char * const hex, const size_t out_len) {
+    __m128i valid = _mm_set1_epi8(-1);
+
+    // 32 hex chars to 16 bytes at a time
+    size_t i = 0;
+    for (i=0; i+16<=out_len; i+=16) {
+        const __m128i a = __hexfont_hex_nibbles_sse2(_mm_loadu_si128((const __m128i *)(hex + 2*i)), &valid);
+        const __m128i b = __hexfont_hex_nibbles_sse2(_mm_loadu_si128((const __m128i *)(hex + 2*i + 16)), &valid);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(a, b));
+    }
+
+    // 16 hex chars to 8 bytes
+    if (i+8 <= out_len) {
+        const __m128i a = __hexfont_hex_nibbles_sse2(_mm_loadu_si128((const __m128i *)(hex + 2*i)), &valid);
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(a, a));
+        i += 8;
+    }
+
+    if (_mm_movemask_epi8(valid) != 0xffff) {
+        return false;
+    }
+
+    return __hexfont_hex_decode_scalar(out + i, hex + 2*i, out_len - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i __hexfont_hex_nibbles_avx2(const __m256i chars, __m256i * const valid) {
+    const __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+
+    const __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    const __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+
+    const __m256i value = _mm256_or_si256(
+        _mm256_and_si256(digit, is_digit),
+        _mm256_and_si256(_mm256_add_epi8(alpha, _mm256_set1_epi8(10)), is_alpha));
+    *valid = _mm256_and_si256(*valid, _mm256_or_si256(is_digit, is_alpha));
+
+    return _mm256_or_si256(
+        _mm256_slli_epi16(_mm256_and_si256(value, _mm256_set1_epi16(0x00ff)), 4),
+        _mm256_srli_epi16(value, 8));
+}
+
+__attribute__((target("avx2")))
+const bool __hexfont_hex_decode_avx2(uint8_t * const out, const char * const hex, const size_t out_len) {
+    __m256i valid = _mm256_set1_epi8(-1);
+
+    // 64 hex chars to 32 bytes at a time, the pack works within 128 bit
+    // lanes so the 64 bit quarters need putting back in order
+    size_t i = 0;
+    for (i=0; i+32<=out_len; i+=32) {
+        const __m256i a = __hexfont_hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *)(hex + 2*i)), &valid);
+        const __m256i b = __hexfont_hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *)(hex + 2*i + 32)), &valid);
+        _mm256_storeu_si256((__m256i *)(out + i),
+                            _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8));
+    }
+
+    if ((uint32_t)_mm256_movemask_epi8(valid) != 0xffffffff) {
+        return false;
+    }
+
+    // 32 byte glyphs and any remainder go through the SSE2 path
+    return __hexfont_hex_decode_sse2(out + i, hex + 2*i, out_len - i);
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static const bool __hexfont_hex_decode_dispatch(uint8_t * const out, const char * const hex, const size_t out_len) {
+    static const __hexfont_hex_decode_function kernels[] = {
+        __hexfont_hex_decode_scalar,
+#ifdef HEXFONT_HEX_HAVE_X86
+        __hexfont_hex_decode_sse2,
+        __hexfont_hex_decode_avx2,
+#endif
+    };
+    const __hexfont_hex_decode_function kernel = kernels[__hexfont_dispatch_index(sizeof(kernels) / sizeof(kernels[0]))];
+    __HEXFONT_DISPATCH_STORE(__hexfont_hex_decode_impl, kernel);
+
+    return kernel(out, hex, out_len);
+}
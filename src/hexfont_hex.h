@@ -0,0 +1,64 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_HEX_H__
+#define __HEXFONT_HEX_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of hex chars which encode one byte
+#define HEXFONT_HEX_CHARS_PER_BYTE 2
+
+/**
+ * Decode out_len bytes from 2*out_len hex digit chars (either case).
+ * Returns false if any of the chars is not a hex digit, in which case the
+ * contents of out are unspecified.
+ * The best implementation for the running CPU is selected on first use.
+  */
+const bool __hexfont_hex_decode(uint8_t * const out, const char * const hex, const size_t out_len);
+
+/**
+ * Parse a number of 1 to 8 hex digit chars.
+ * Returns false if len is out of range or any char is not a hex digit.
+  */
+const bool __hexfont_hex_parse_uint32(uint32_t * const value, const char * const hex, const size_t len);
+
+// Individual implementations, exposed for benchmarking
+const bool __hexfont_hex_decode_scalar(uint8_t * const out, const char * const hex, const size_t out_len);
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEXFONT_HEX_HAVE_X86 1
+const bool __hexfont_hex_decode_sse2(uint8_t * const out, const char * const hex, const size_t out_len);
+const bool __hexfont_hex_decode_avx2(uint8_t * const out, const char * const hex, const size_t out_len);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_HEX_H__
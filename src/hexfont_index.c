@@ -0,0 +1,89 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_index.h"
+
+static inline const uint32_t __hexfont_index_codepoint(const void * const codepoints, const size_t stride, const uint32_t i);
+
+
+const bool __hexfont_index_build(__hexfont_index * const index, __hexfont_arena * const arena, const void * const codepoints, const size_t stride, const uint32_t length) {
+    // The directory only needs to reach the highest codepoint
+    uint32_t max_codepoint = 0;
+    uint32_t i = 0;
+    for (i=0; i<length; i++) {
+        const uint32_t codepoint = __hexfont_index_codepoint(codepoints, stride, i);
+        if (codepoint > max_codepoint) {
+            max_codepoint = codepoint;
+        }
+    }
+    index->directory_length = (length > 0) ? (max_codepoint >> HEXFONT_PAGE_BITS) + 1 : 0;
+
+    index->directory = __hexfont_arena_alloc(
+                            arena,
+                            (index->directory_length + 1) * sizeof(uint32_t),
+                            sizeof(uint32_t));
+    if (index->directory == NULL) {
+        return false;
+    }
+    memset(index->directory, 0, index->directory_length * sizeof(uint32_t));
+
+    // Mark the blocks which are used and number their pages in codepoint order
+    for (i=0; i<length; i++) {
+        index->directory[__hexfont_index_codepoint(codepoints, stride, i) >> HEXFONT_PAGE_BITS] = 1;
+    }
+    index->page_count = 1;
+    for (i=0; i<index->directory_length; i++) {
+        if (index->directory[i]) {
+            index->directory[i] = index->page_count++;
+        }
+    }
+
+    index->pages = __hexfont_arena_alloc(
+                            arena,
+                            (size_t)index->page_count * HEXFONT_PAGE_SIZE * sizeof(uint32_t),
+                            sizeof(uint32_t));
+    if (index->pages == NULL) {
+        return false;
+    }
+    memset(index->pages, 0, (size_t)index->page_count * HEXFONT_PAGE_SIZE * sizeof(uint32_t));
+
+    for (i=0; i<length; i++) {
+        const uint32_t codepoint = __hexfont_index_codepoint(codepoints, stride, i);
+        uint32_t * const slot = &index->pages[
+            ((size_t)index->directory[codepoint >> HEXFONT_PAGE_BITS] << HEXFONT_PAGE_BITS) |
+            (codepoint & HEXFONT_PAGE_MASK)];
+        if (*slot == 0) {
+            *slot = i + 1;
+        }
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static inline const uint32_t __hexfont_index_codepoint(const void * const codepoints, const size_t stride, const uint32_t i) {
+    return *(const uint32_t *)((const uint8_t *)codepoints + (size_t)i * stride);
+}
@@ -0,0 +1,62 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_INDEX_H__
+#define __HEXFONT_INDEX_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hexfont_arena.h"
+
+/**
+ * A two level lookup table from codepoint to character number.
+ * The directory holds a page number for each block of HEXFONT_PAGE_SIZE
+ * codepoints, and each page holds a character number (index + 1) for
+ * each codepoint in the block. Page 0 is always empty and is shared by
+ * every block which has no characters.
+  */
+typedef struct __hexfont_index {
+    uint32_t *directory;
+    uint32_t *pages;
+    uint32_t directory_length;
+    uint32_t page_count;
+
+} __hexfont_index;
+
+/**
+ * Build an index over length codepoints, the ith of which is read from
+ * codepoints + i*stride so that it can be pointed at a field of an array
+ * of structs. When a codepoint occurs more than once the first one wins.
+  */
+const bool __hexfont_index_build(__hexfont_index * const index, __hexfont_arena * const arena, const void * const codepoints, const size_t stride, const uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_INDEX_H__
@@ -0,0 +1,364 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_layout.h"
+#include "hexfont_list.h"
+#include "hexfont_utf8.h"
+
+// Room made for lines and text when there is none left
+#define HEXFONT_LAYOUT_INITIAL_LINES 16
+#define HEXFONT_LAYOUT_INITIAL_TEXT 256
+
+// Longest UTF-8 sequence
+#define HEXFONT_LAYOUT_MAX_SEQUENCE 4
+
+/**
+ * Lines are in order of their offsets, which only ever go up, and there
+ * is always at least one.
+ * Lines which are laid out again are put in scratch before they are
+ * swapped in, and the bytes being replaced are kept in removed until
+ * that has worked, both are kept from one change to the next.
+  */
+struct hexfont_layout {
+    hexfont *font;
+    hexfont_list *fonts;
+    int32_t width;
+    char *text;
+    size_t length;
+    size_t capacity;
+    hexfont_line *lines;
+    size_t line_count;
+    size_t line_capacity;
+    hexfont_line *scratch;
+    size_t scratch_capacity;
+    char *removed;
+    size_t removed_capacity;
+};
+
+static hexfont_layout * const __hexfont_layout_create(hexfont * const font, hexfont_list * const fonts, const int32_t width);
+static const bool __hexfont_layout_update(hexfont_layout * const layout, const size_t offset, const size_t old_end, const size_t new_end);
+static const bool __hexfont_layout_break(const hexfont_layout * const layout, const size_t start, hexfont_line * const line, size_t * const next);
+static const bool __hexfont_layout_reserve(void ** const items, size_t * const capacity, const size_t needed, const size_t item_size, const size_t initial);
+static inline const int32_t __hexfont_layout_advance(const hexfont_layout * const layout, const uint32_t codepoint);
+
+
+hexfont_layout * const hexfont_layout_create(hexfont * const font, const int32_t width) {
+    return __hexfont_layout_create(font, NULL, width);
+}
+
+hexfont_layout * const hexfont_list_layout_create(hexfont_list * const fonts, const int32_t width) {
+    return __hexfont_layout_create(NULL, fonts, width);
+}
+
+void hexfont_layout_destroy(hexfont_layout * const layout) {
+    if (layout == NULL) {
+        return;
+    }
+
+    free(layout->text);
+    free(layout->lines);
+    free(layout->scratch);
+    free(layout->removed);
+    free(layout);
+}
+
+const bool hexfont_layout_append(hexfont_layout * const layout, const char * const text, const size_t len) {
+    return hexfont_layout_replace(layout, layout->length, 0, text, len);
+}
+
+const bool hexfont_layout_replace(hexfont_layout * const layout, const size_t offset, const size_t remove, const char * const text, const size_t len) {
+    if (offset > layout->length || remove > layout->length - offset) {
+        return false;
+    }
+
+    const size_t length = layout->length - remove + len;
+    if (!__hexfont_layout_reserve((void **)&layout->text, &layout->capacity, length, 1, HEXFONT_LAYOUT_INITIAL_TEXT) ||
+        !__hexfont_layout_reserve((void **)&layout->removed, &layout->removed_capacity, remove, 1, HEXFONT_LAYOUT_INITIAL_TEXT)) {
+        return false;
+    }
+
+    const size_t tail = layout->length - offset - remove;
+    if (remove > 0) {
+        memcpy(layout->removed, layout->text + offset, remove);
+    }
+    memmove(layout->text + offset + len, layout->text + offset + remove, tail);
+    memcpy(layout->text + offset, text, len);
+    layout->length = length;
+
+    // The lines are only changed once there is room for them all, so
+    // putting the text back leaves the layout as it was
+    if (!__hexfont_layout_update(layout, offset, offset + remove, offset + len)) {
+        memmove(layout->text + offset + remove, layout->text + offset + len, tail);
+        if (remove > 0) {
+            memcpy(layout->text + offset, layout->removed, remove);
+        }
+        layout->length = length - len + remove;
+        return false;
+    }
+
+    return true;
+}
+
+const bool hexfont_layout_set_width(hexfont_layout * const layout, const int32_t width) {
+    const int32_t old_width = layout->width;
+    const size_t line_count = layout->line_count;
+
+    layout->width = width;
+    layout->line_count = 0;
+    if (!__hexfont_layout_update(layout, 0, 0, 0)) {
+        layout->width = old_width;
+        layout->line_count = line_count;
+        return false;
+    }
+
+    return true;
+}
+
+const char * const hexfont_layout_get_text(const hexfont_layout * const layout, size_t * const len) {
+    if (len) {
+        *len = layout->length;
+    }
+
+    return layout->text;
+}
+
+const hexfont_line * const hexfont_layout_get_lines(const hexfont_layout * const layout, size_t * const line_count) {
+    if (line_count) {
+        *line_count = layout->line_count;
+    }
+
+    return layout->lines;
+}
+
+const size_t hexfont_layout_find_line(const hexfont_layout * const layout, const size_t offset) {
+    // The first line starts at 0 so there is always one at or before offset
+    size_t lo = 0;
+    size_t hi = layout->line_count;
+    while (hi - lo > 1) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (layout->lines[mid].offset <= offset) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static hexfont_layout * const __hexfont_layout_create(hexfont * const font, hexfont_list * const fonts, const int32_t width) {
+    hexfont_layout * const layout = calloc(1, sizeof(hexfont_layout));
+    if (layout == NULL) {
+        return NULL;
+    }
+
+    layout->font = font;
+    layout->fonts = fonts;
+    if (!__hexfont_layout_reserve((void **)&layout->text, &layout->capacity, 1, 1, HEXFONT_LAYOUT_INITIAL_TEXT) ||
+        !hexfont_layout_set_width(layout, width)) {
+        hexfont_layout_destroy(layout);
+        return NULL;
+    }
+
+    return layout;
+}
+
+/**
+ * Lay out the text again after bytes [offset, old_end) were changed to
+ * [offset, new_end).
+ * A line's break only depends on the text up to the first word of the
+ * next line, so lines from the one before the change could be different.
+ * From there lines are broken until one starts after the change where an
+ * old one did, the rest are the same as before once moved.
+*/
+static const bool __hexfont_layout_update(hexfont_layout * const layout, const size_t offset, const size_t old_end, const size_t new_end) {
+    const ptrdiff_t delta = (ptrdiff_t)new_end - (ptrdiff_t)old_end;
+
+    // The change may have completed a sequence which began up to 3 bytes before it
+    size_t first = 0;
+    if (layout->line_count > 0) {
+        first = hexfont_layout_find_line(layout, (offset > HEXFONT_LAYOUT_MAX_SEQUENCE - 1) ? offset - (HEXFONT_LAYOUT_MAX_SEQUENCE - 1) : 0);
+        if (first > 0 && layout->text[layout->lines[first].offset - 1] != '\n') {
+            first--;
+        }
+    }
+
+    size_t start = (layout->line_count > 0) ? layout->lines[first].offset : 0;
+    size_t old = first + 1;
+    size_t count = 0;
+    while (true) {
+        if (!__hexfont_layout_reserve((void **)&layout->scratch, &layout->scratch_capacity, count + 1, sizeof(hexfont_line), HEXFONT_LAYOUT_INITIAL_LINES)) {
+            return false;
+        }
+
+        size_t next;
+        if (!__hexfont_layout_break(layout, start, &layout->scratch[count++], &next)) {
+            // The end of the text, none of the old lines are left
+            old = layout->line_count;
+            break;
+        }
+        start = next;
+
+        // Old lines which start before this one can't line up any more
+        if (start >= new_end) {
+            while (old < layout->line_count && (ptrdiff_t)layout->lines[old].offset + delta < (ptrdiff_t)start) {
+                old++;
+            }
+            if (old < layout->line_count && (ptrdiff_t)layout->lines[old].offset + delta == (ptrdiff_t)start) {
+                break;
+            }
+        }
+    }
+
+    // Swap old lines [first, old) for the new ones and move the rest
+    const size_t kept = layout->line_count - old;
+    if (!__hexfont_layout_reserve((void **)&layout->lines, &layout->line_capacity, first + count + kept, sizeof(hexfont_line), HEXFONT_LAYOUT_INITIAL_LINES)) {
+        return false;
+    }
+
+    memmove(&layout->lines[first + count], &layout->lines[old], kept * sizeof(hexfont_line));
+    memcpy(&layout->lines[first], layout->scratch, count * sizeof(hexfont_line));
+    layout->line_count = first + count + kept;
+
+    if (delta != 0) {
+        size_t i = 0;
+        for (i=first + count; i<layout->line_count; i++) {
+            layout->lines[i].offset += delta;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Break off the line which starts at byte start, and where the next one
+ * starts. false means it is the last line, which runs to the end of the
+ * text.
+ * A line ends at a '\n', or when the next character doesn't fit: after
+ * the last word followed by spaces or, without one, before the character.
+ * A line always has a character, however wide it is, unless it is empty.
+*/
+static const bool __hexfont_layout_break(const hexfont_layout * const layout, const size_t start, hexfont_line * const line, size_t * const next) {
+    const char * const text = layout->text;
+    const char * const end = text + layout->length;
+    const char * const line_start = text + start;
+    const bool wrap = (layout->width > 0);
+    const char *p = line_start;
+    int32_t x = 0;
+
+    // The run of spaces being read, and the last one before a word,
+    // which is where the line can be broken
+    bool spaces = false;
+    const char *space_start = NULL;
+    int32_t space_x = 0;
+    const char *break_end = NULL;
+    const char *break_next = NULL;
+    int32_t break_x = 0;
+
+    line->offset = start;
+    while (p < end) {
+        const char * const at = p;
+        const uint32_t codepoint = __hexfont_utf8_next(&p, end);
+        if (codepoint == '\n') {
+            line->length = ((wrap && spaces) ? space_start : at) - line_start;
+            line->width = (wrap && spaces) ? space_x : x;
+            *next = p - text;
+            return true;
+        }
+
+        const int32_t advance = __hexfont_layout_advance(layout, codepoint);
+        if (codepoint == ' ') {
+            if (!spaces) {
+                spaces = true;
+                space_start = at;
+                space_x = x;
+            }
+            x += advance;
+            continue;
+        }
+
+        if (spaces) {
+            spaces = false;
+            break_end = space_start;
+            break_next = at;
+            break_x = space_x;
+        }
+
+        if (wrap && x + advance > layout->width && at > line_start) {
+            if (break_end) {
+                line->length = break_end - line_start;
+                line->width = break_x;
+                *next = break_next - text;
+            }
+            else {
+                line->length = at - line_start;
+                line->width = x;
+                *next = at - text;
+            }
+            return true;
+        }
+        x += advance;
+    }
+
+    line->length = ((wrap && spaces) ? space_start : end) - line_start;
+    line->width = (wrap && spaces) ? space_x : x;
+    *next = layout->length;
+
+    return false;
+}
+
+// Grow items to hold at least needed of them, doubling each time
+static const bool __hexfont_layout_reserve(void ** const items, size_t * const capacity, const size_t needed, const size_t item_size, const size_t initial) {
+    if (needed <= *capacity) {
+        return true;
+    }
+
+    size_t new_capacity = (*capacity > 0) ? *capacity : initial;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    void * const resized = realloc(*items, new_capacity * item_size);
+    if (resized == NULL) {
+        return false;
+    }
+    *items = resized;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+static inline const int32_t __hexfont_layout_advance(const hexfont_layout * const layout, const uint32_t codepoint) {
+    const hexfont_metrics * const m = (layout->font) ?
+            hexfont_get_metrics(layout->font, codepoint) :
+            hexfont_list_get_metrics(layout->fonts, codepoint);
+
+    return (m) ? m->advance : 0;
+}
@@ -0,0 +1,274 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hexfont.h"
+#include "hexfont_arena.h"
+#include "hexfont_builder.h"
+#include "hexfont_hex.h"
+#include "hexfont_index.h"
+#include "hexfont_source.h"
+#include "hexfont_stats.h"
+
+// Number of entries to make room for before the count is known
+#define HEXFONT_LAZY_INITIAL_CAPACITY 256
+
+/**
+ * Where the glyph chars of a codepoint start in the file
+  */
+typedef struct __hexfont_lazy_entry {
+    uint32_t codepoint;
+    uint32_t offset;
+
+} __hexfont_lazy_entry;
+
+/**
+ * A font file which is decoded on demand.
+ * Decoded glyphs go into the font's arena, which is guarded by the lock,
+ * characters are published into their slots once they are complete.
+ * Metrics are filled in at the same time, the font's metrics table
+ * is owned by the source.
+  */
+typedef struct __hexfont_lazy_source {
+    __hexfont_source source;
+    const char *mapping;
+    size_t mapping_size;
+    __hexfont_lazy_entry *entries;
+    hexfont_character *slots;
+    hexfont_metrics *metrics;
+    pthread_mutex_t lock;
+
+} __hexfont_lazy_source;
+
+static hexfont_character * const __hexfont_lazy_get(hexfont * const font, const uint32_t index);
+static void __hexfont_lazy_destroy(__hexfont_source * const source);
+static const bool __hexfont_lazy_scan(__hexfont_lazy_source * const lazy, uint32_t * const length);
+
+
+hexfont * const hexfont_load_lazy(const char *file, const uint8_t glyph_height) {
+    const uint64_t started = __hexfont_stats_now();
+    const int fd = open(file, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    // Offsets are 32 bit and the file has to be mappable
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+        st.st_size == 0 || (uint64_t)st.st_size > UINT32_MAX) {
+        close(fd);
+        return hexfont_load(file, glyph_height);
+    }
+
+    const char * const mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return hexfont_load(file, glyph_height);
+    }
+
+    hexfont * const font = malloc(sizeof(hexfont));
+    __hexfont_lazy_source * const lazy = malloc(sizeof(__hexfont_lazy_source));
+    if (font == NULL || lazy == NULL) {
+        free(font);
+        free(lazy);
+        munmap((void *)mapping, st.st_size);
+        return NULL;
+    }
+
+    lazy->source.get = __hexfont_lazy_get;
+    lazy->source.destroy = __hexfont_lazy_destroy;
+    lazy->source.stats = NULL;
+    lazy->mapping = mapping;
+    lazy->mapping_size = st.st_size;
+    lazy->entries = NULL;
+    lazy->slots = NULL;
+    lazy->metrics = NULL;
+    pthread_mutex_init(&lazy->lock, NULL);
+
+    font->directory = NULL;
+    font->pages = NULL;
+    font->directory_length = 0;
+    font->characters = NULL;
+    font->length = 0;
+    font->metrics = NULL;
+    font->glyph_height = glyph_height;
+    font->source = &lazy->source;
+    font->embedded = false;
+    font->counters = __hexfont_counters_create();
+    font->arena = __hexfont_arena_create();
+
+    __hexfont_index index;
+    bool ok = (font->arena != NULL) && __hexfont_lazy_scan(lazy, &font->length);
+    const uint64_t scanned = __hexfont_stats_now();
+
+    // Slots are zeroed pages until a character is first used
+    if (ok) {
+        lazy->slots = calloc(font->length > 0 ? font->length : 1, sizeof(hexfont_character));
+        lazy->metrics = calloc(font->length > 0 ? font->length : 1, sizeof(hexfont_metrics));
+        font->metrics = lazy->metrics;
+        ok = (lazy->slots != NULL && lazy->metrics != NULL);
+    }
+
+    ok = ok && __hexfont_index_build(
+                            &index,
+                            font->arena,
+                            (lazy->entries) ? &lazy->entries[0].codepoint : NULL,
+                            sizeof(__hexfont_lazy_entry),
+                            font->length);
+    if (!ok) {
+        hexfont_destroy(font);
+        return NULL;
+    }
+
+    font->directory = index.directory;
+    font->pages = index.pages;
+    font->directory_length = index.directory_length;
+
+    // Parsing is only the scan, glyphs are decoded later and counted then
+    if (font->counters) {
+        font->counters->parse_ns = scanned - started;
+        font->counters->index_ns = __hexfont_stats_now() - scanned;
+    }
+
+    // The scan touched every page of the file, drop them until they are needed
+    madvise((void *)mapping, st.st_size, MADV_DONTNEED);
+
+    return font;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static hexfont_character * const __hexfont_lazy_get(hexfont * const font, const uint32_t index) {
+    __hexfont_lazy_source * const lazy = (__hexfont_lazy_source *)font->source;
+    hexfont_character * const c = &lazy->slots[index];
+
+    if (__atomic_load_n(&c->glyph, __ATOMIC_ACQUIRE) != NULL) {
+        return c;
+    }
+
+    // Find the glyph chars, which run to the end of the line
+    const char * const glyph_chars = lazy->mapping + lazy->entries[index].offset;
+    const size_t remaining = lazy->mapping_size - lazy->entries[index].offset;
+    const char * const newline = memchr(glyph_chars, '\n', remaining);
+    size_t glyph_chars_len = (newline) ? (size_t)(newline - glyph_chars) : remaining;
+    if (glyph_chars_len > 0 && glyph_chars[glyph_chars_len - 1] == '\r') {
+        glyph_chars_len--;
+    }
+    const size_t glyph_len = glyph_chars_len / HEXFONT_HEX_CHARS_PER_BYTE;
+
+    pthread_mutex_lock(&lazy->lock);
+
+    // Another thread may have got here first
+    if (c->glyph == NULL) {
+        uint8_t * const glyph = __hexfont_arena_alloc(font->arena, glyph_len, 1);
+
+        // Unlike the eager loader a line with a bad glyph is only noticed
+        // now, and it hides any later line for the same codepoint. It is
+        // decoded again on every lookup, so its room is given back
+        if (glyph == NULL || glyph_len == 0 ||
+            !__hexfont_hex_decode(glyph, glyph_chars, glyph_len)) {
+            if (glyph) {
+                __hexfont_arena_free_last(font->arena, glyph, glyph_len);
+            }
+            pthread_mutex_unlock(&lazy->lock);
+            return NULL;
+        }
+
+        __HEXFONT_COUNT(font, decodes);
+
+        hexfont_metrics metrics;
+        c->codepoint = lazy->entries[index].codepoint;
+        c->glyph_len = glyph_len;
+        c->height = font->glyph_height;
+        c->width = __hexfont_calculate_metrics(&metrics, glyph, glyph_len, font->glyph_height);
+
+        // The advance tells hexfont_get_metrics that the rest is there
+        hexfont_metrics * const m = &lazy->metrics[index];
+        memcpy(m, &metrics, offsetof(hexfont_metrics, advance));
+        __atomic_store_n(&m->advance, metrics.advance, __ATOMIC_RELEASE);
+        __atomic_store_n(&c->glyph, glyph, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&lazy->lock);
+
+    return c;
+}
+
+static void __hexfont_lazy_destroy(__hexfont_source * const source) {
+    __hexfont_lazy_source * const lazy = (__hexfont_lazy_source *)source;
+
+    munmap((void *)lazy->mapping, lazy->mapping_size);
+    pthread_mutex_destroy(&lazy->lock);
+    free(lazy->entries);
+    free(lazy->slots);
+    free(lazy->metrics);
+    free(lazy);
+}
+
+/**
+ * Record the codepoint and glyph offset of every line, without decoding
+*/
+static const bool __hexfont_lazy_scan(__hexfont_lazy_source * const lazy, uint32_t * const length) {
+    const char * const end = lazy->mapping + lazy->mapping_size;
+    const char *line = lazy->mapping;
+    uint32_t capacity = 0;
+
+    *length = 0;
+    while (line < end) {
+        const char * const newline = memchr(line, '\n', end - line);
+        const char * const line_end = (newline) ? newline : end;
+        const char * const sep = memchr(line, ':', line_end - line);
+
+        uint32_t codepoint;
+        if (sep != NULL &&
+            __hexfont_hex_parse_uint32(&codepoint, line, sep - line) &&
+            codepoint <= HEXFONT_MAX_CODEPOINT) {
+            if (*length == capacity) {
+                const uint32_t new_capacity =
+                    (capacity > 0) ? capacity * 2 : HEXFONT_LAZY_INITIAL_CAPACITY;
+                __hexfont_lazy_entry * const entries =
+                    realloc(lazy->entries, (size_t)new_capacity * sizeof(__hexfont_lazy_entry));
+                if (entries == NULL) {
+                    return false;
+                }
+                lazy->entries = entries;
+                capacity = new_capacity;
+            }
+
+            lazy->entries[*length].codepoint = codepoint;
+            lazy->entries[*length].offset = (sep + 1) - lazy->mapping;
+            (*length)++;
+        }
+
+        line = line_end + 1;
+    }
+
+    return true;
+}
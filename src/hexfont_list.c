@@ -26,13 +26,24 @@
 #include "hexfont.h"
 #include "hexfont_list.h"
 
+static hexfont_list * const __hexfont_list_node_create(hexfont * const item);
+static void __hexfont_list_index_add(hexfont_list * const head, hexfont_list * const node);
+static const bool __hexfont_list_index_merge(__hexfont_list_index * const index, hexfont * const font, const uint32_t font_number);
+static void __hexfont_list_index_destroy(__hexfont_list_index * const index);
+
 
 hexfont_list * const hexfont_list_create(hexfont * const item) {
     // Allocate memory for the head element
-    hexfont_list * const font_list = malloc(sizeof(hexfont_list));
+    hexfont_list * const font_list = __hexfont_list_node_create(item);
+    if (font_list == NULL) {
+        return NULL;
+    }
 
-    font_list->item = item;
-    font_list->next = NULL;
+    // Only the head has an index, lookups walk the list if there isn't one
+    font_list->index = calloc(1, sizeof(__hexfont_list_index));
+    if (font_list->index && item) {
+        __hexfont_list_index_add(font_list, font_list);
+    }
 
     return font_list;
 }
@@ -42,6 +53,8 @@ void hexfont_list_destroy(hexfont_list * const head) {
         return;
     }
 
+    __hexfont_list_index_destroy(head->index);
+
     hexfont_list *tmp, *iter = head;
     while (iter->next) {
         tmp = iter;
@@ -68,7 +81,12 @@ void hexfont_list_append(hexfont_list * const head, hexfont * const new_item) {
         tail->item = new_item;
     }
     else {
-        tail->next = hexfont_list_create(new_item);
+        tail->next = __hexfont_list_node_create(new_item);
+        tail = tail->next;
+    }
+
+    if (head->index && tail && new_item) {
+        __hexfont_list_index_add(head, tail);
     }
 }
 
@@ -86,15 +104,139 @@ uint16_t hexfont_list_get_length(hexfont_list * const head) {
 }
 
 hexfont * const hexfont_list_get_nth(hexfont_list * const head, int16_t n) {
-    if (hexfont_list_get_length(head) <= n) {
+    if (n < 0) {
         return NULL;
     }
 
+    // A single walk, stopping early if the list is too short
     int16_t i;
     hexfont_list *iter = head;
-    for (i=0; i<n; i++) {
+    for (i=0; i<n && iter!=NULL; i++) {
         iter = iter->next;
     }
+
+    if (iter == NULL) {
+        return NULL;
+    }
     return iter->item;
 }
 
+hexfont * const __hexfont_list_find_slow(hexfont_list * const from, const uint32_t codepoint, uint32_t * const number) {
+    hexfont_list *iter;
+    for (iter=from; iter!=NULL; iter=iter->next) {
+        if (iter->item) {
+            *number = __hexfont_find(iter->item, codepoint);
+            if (*number) {
+                return iter->item;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static hexfont_list * const __hexfont_list_node_create(hexfont * const item) {
+    hexfont_list * const node = malloc(sizeof(hexfont_list));
+    if (node == NULL) {
+        return NULL;
+    }
+
+    node->item = item;
+    node->next = NULL;
+    node->index = NULL;
+
+    return node;
+}
+
+static void __hexfont_list_index_add(hexfont_list * const head, hexfont_list * const node) {
+    __hexfont_list_index * const index = head->index;
+
+    // Once a font has been left out, later fonts can't be indexed either
+    // or they would hide the codepoints it has
+    if (index->unindexed) {
+        return;
+    }
+
+    if (index->font_count == HEXFONT_LIST_MAX_INDEXED_FONTS) {
+        index->unindexed = node;
+        return;
+    }
+
+    // The font goes in first, a merge which runs out of memory partway
+    // leaves entries for it behind. Its other codepoints are then found
+    // by searching from it, as no earlier font has them either
+    index->fonts[index->font_count++] = node->item;
+    if (!__hexfont_list_index_merge(index, node->item, index->font_count)) {
+        index->unindexed = node;
+    }
+}
+
+/**
+ * Add the codepoints of font which no earlier font has
+*/
+static const bool __hexfont_list_index_merge(__hexfont_list_index * const index, hexfont * const font, const uint32_t font_number) {
+    // Page 0 is the shared empty page
+    if (index->page_count == 0) {
+        index->pages = calloc(HEXFONT_PAGE_SIZE, sizeof(uint32_t));
+        if (index->pages == NULL) {
+            return false;
+        }
+        index->page_count = 1;
+    }
+
+    if (font->directory_length > index->directory_length) {
+        uint32_t * const directory =
+            realloc(index->directory, font->directory_length * sizeof(uint32_t));
+        if (directory == NULL) {
+            return false;
+        }
+        memset(directory + index->directory_length,
+               0,
+               (font->directory_length - index->directory_length) * sizeof(uint32_t));
+        index->directory = directory;
+        index->directory_length = font->directory_length;
+    }
+
+    uint32_t block = 0;
+    for (block=0; block<font->directory_length; block++) {
+        if (font->directory[block] == 0) {
+            continue;
+        }
+
+        if (index->directory[block] == 0) {
+            uint32_t * const pages = realloc(
+                            index->pages,
+                            ((size_t)index->page_count + 1) * HEXFONT_PAGE_SIZE * sizeof(uint32_t));
+            if (pages == NULL) {
+                return false;
+            }
+            memset(pages + (size_t)index->page_count * HEXFONT_PAGE_SIZE, 0, HEXFONT_PAGE_SIZE * sizeof(uint32_t));
+            index->pages = pages;
+            index->directory[block] = index->page_count++;
+        }
+
+        const uint32_t * const src = font->pages + ((size_t)font->directory[block] << HEXFONT_PAGE_BITS);
+        uint32_t * const dst = index->pages + ((size_t)index->directory[block] << HEXFONT_PAGE_BITS);
+        uint32_t i = 0;
+        for (i=0; i<HEXFONT_PAGE_SIZE; i++) {
+            if (src[i] && dst[i] == 0) {
+                dst[i] = (font_number << HEXFONT_LIST_FONT_SHIFT) |
+                         ((src[i] <= HEXFONT_LIST_NUMBER_MASK) ? src[i] : 0);
+            }
+        }
+    }
+
+    return true;
+}
+
+static void __hexfont_list_index_destroy(__hexfont_list_index * const index) {
+    if (index == NULL) {
+        return;
+    }
+
+    free(index->directory);
+    free(index->pages);
+    free(index);
+}
@@ -0,0 +1,174 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_builder.h"
+#include "hexfont_subset.h"
+
+// Room made for a split line the first time there is one
+#define HEXFONT_LOADER_INITIAL_PARTIAL 256
+
+/**
+ * Lines are parsed straight out of the data they are fed in, only a line
+ * which is split between two calls is put together in the partial buffer.
+  */
+struct hexfont_loader {
+    __hexfont_builder builder;
+    char *partial;
+    size_t partial_len;
+    size_t partial_capacity;
+
+    // Set while the rest of an overlong line is thrown away
+    bool skipping;
+
+    // Set once out of memory, everything after that is ignored
+    bool failed;
+
+    // Hand back a compact copy of the font
+    bool compact;
+};
+
+static const bool __hexfont_loader_keep(hexfont_loader * const loader, const char * const data, const size_t len);
+
+
+hexfont_loader * const hexfont_loader_create(const uint8_t glyph_height, const unsigned int flags) {
+    hexfont_loader * const loader = malloc(sizeof(hexfont_loader));
+    if (loader == NULL) {
+        return NULL;
+    }
+
+    if (!__hexfont_builder_init(&loader->builder, glyph_height)) {
+        free(loader);
+        return NULL;
+    }
+
+    loader->builder.dedup = (flags & HEXFONT_LOAD_DEDUP) != 0;
+    loader->partial = NULL;
+    loader->partial_len = 0;
+    loader->partial_capacity = 0;
+    loader->skipping = false;
+    loader->failed = false;
+    loader->compact = (flags & HEXFONT_LOAD_COMPACT) != 0;
+
+    return loader;
+}
+
+void hexfont_loader_set_subset(hexfont_loader * const loader, const hexfont_subset * const subset) {
+    loader->builder.subset = subset;
+}
+
+const bool hexfont_loader_feed(hexfont_loader * const loader, const void * const data, const size_t len) {
+    const char *p = data;
+    const char * const end = p + len;
+
+    while (!loader->failed && p < end) {
+        const char * const newline = memchr(p, '\n', end - p);
+        if (newline == NULL) {
+            // Keep the start of the line until the rest of it comes
+            loader->failed = !__hexfont_loader_keep(loader, p, end - p);
+            break;
+        }
+
+        const char * const next = newline + 1;
+        if (loader->skipping) {
+            // This is the end of an overlong line
+            loader->skipping = false;
+        }
+        else if (loader->partial_len > 0) {
+            // Finish the line which was split between calls
+            loader->failed = !__hexfont_loader_keep(loader, p, next - p) ||
+                             (!loader->skipping &&
+                              !__hexfont_builder_add_line(&loader->builder, loader->partial, loader->partial_len));
+            loader->partial_len = 0;
+            loader->skipping = false;
+        }
+        else {
+            loader->failed = !__hexfont_builder_add_line(&loader->builder, p, next - p);
+        }
+
+        p = next;
+    }
+
+    return !loader->failed;
+}
+
+hexfont * const hexfont_loader_finish(hexfont_loader * const loader) {
+    // The last line need not end with a '\n'
+    if (!loader->failed && !loader->skipping && loader->partial_len > 0) {
+        loader->failed = !__hexfont_builder_add_line(&loader->builder, loader->partial, loader->partial_len);
+    }
+
+    hexfont *font = (loader->failed) ? NULL : __hexfont_builder_finish(&loader->builder);
+    if (font && loader->compact) {
+        hexfont * const compact = hexfont_compact(font);
+        hexfont_destroy(font);
+        font = compact;
+    }
+    hexfont_loader_destroy(loader);
+
+    return font;
+}
+
+void hexfont_loader_destroy(hexfont_loader * const loader) {
+    __hexfont_builder_abort(&loader->builder);
+    free(loader->partial);
+    free(loader);
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+/**
+ * Add len chars to the partial line, or start skipping it once it is too long
+*/
+static const bool __hexfont_loader_keep(hexfont_loader * const loader, const char * const data, const size_t len) {
+    if (loader->skipping) {
+        return true;
+    }
+
+    if (len > HEXFONT_BUILDER_MAX_LINE - loader->partial_len) {
+        loader->partial_len = 0;
+        loader->skipping = true;
+        return true;
+    }
+
+    if (loader->partial_len + len > loader->partial_capacity) {
+        size_t capacity = (loader->partial_capacity > 0) ? loader->partial_capacity : HEXFONT_LOADER_INITIAL_PARTIAL;
+        while (capacity < loader->partial_len + len) {
+            capacity *= 2;
+        }
+
+        char * const partial = realloc(loader->partial, capacity);
+        if (partial == NULL) {
+            return false;
+        }
+        loader->partial = partial;
+        loader->partial_capacity = capacity;
+    }
+
+    memcpy(loader->partial + loader->partial_len, data, len);
+    loader->partial_len += len;
+
+    return true;
+}
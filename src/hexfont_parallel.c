@@ -0,0 +1,166 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hexfont.h"
+#include "hexfont_builder.h"
+
+// Upper limit on the number of threads used to load one font
+#define HEXFONT_PARALLEL_MAX_THREADS 64
+
+/**
+ * The part of the file which one thread parses
+  */
+typedef struct __hexfont_parallel_chunk {
+    const char *start;
+    const char *end;
+    uint8_t glyph_height;
+    __hexfont_builder builder;
+    bool ok;
+
+} __hexfont_parallel_chunk;
+
+static void * __hexfont_parallel_worker(void *arg);
+
+
+hexfont * const hexfont_load_parallel(const char *file, const uint8_t glyph_height, unsigned int nthreads) {
+    if (nthreads == 0) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (online > 0) ? online : 1;
+    }
+    if (nthreads > HEXFONT_PARALLEL_MAX_THREADS) {
+        nthreads = HEXFONT_PARALLEL_MAX_THREADS;
+    }
+
+    const int fd = open(file, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    // Anything which can't be mapped, like a pipe, is loaded serially
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return hexfont_load(file, glyph_height);
+    }
+
+    const size_t size = st.st_size;
+    char * const data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return hexfont_load(file, glyph_height);
+    }
+
+    // Split into roughly equal chunks which end on line boundaries
+    __hexfont_parallel_chunk chunks[HEXFONT_PARALLEL_MAX_THREADS];
+    const char * const end = data + size;
+    const char *start = data;
+    unsigned int i = 0;
+    for (i=0; i<nthreads; i++) {
+        const char *chunk_end = data + (size / nthreads) * (i + 1);
+        if (i == nthreads - 1 || chunk_end < start) {
+            chunk_end = (i == nthreads - 1) ? end : start;
+        }
+        else {
+            const char * const newline = memchr(chunk_end, '\n', end - chunk_end);
+            chunk_end = (newline) ? newline + 1 : end;
+        }
+
+        chunks[i].start = start;
+        chunks[i].end = chunk_end;
+        chunks[i].glyph_height = glyph_height;
+        chunks[i].ok = false;
+        start = chunk_end;
+    }
+
+    // The calling thread parses the first chunk itself
+    pthread_t threads[HEXFONT_PARALLEL_MAX_THREADS];
+    bool started[HEXFONT_PARALLEL_MAX_THREADS];
+    for (i=1; i<nthreads; i++) {
+        started[i] = pthread_create(&threads[i], NULL, __hexfont_parallel_worker, &chunks[i]) == 0;
+        if (!started[i]) {
+            __hexfont_parallel_worker(&chunks[i]);
+        }
+    }
+    __hexfont_parallel_worker(&chunks[0]);
+
+    bool ok = chunks[0].ok;
+    for (i=1; i<nthreads; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        ok = ok && chunks[i].ok;
+    }
+    munmap(data, size);
+
+    // Merge in file order so that the result matches the serial loader
+    for (i=1; i<nthreads; i++) {
+        if (ok) {
+            ok = __hexfont_builder_append(&chunks[0].builder, &chunks[i].builder);
+        }
+        else if (chunks[i].ok) {
+            __hexfont_builder_abort(&chunks[i].builder);
+        }
+    }
+    if (!ok) {
+        if (chunks[0].ok) {
+            __hexfont_builder_abort(&chunks[0].builder);
+        }
+        return NULL;
+    }
+
+    return __hexfont_builder_finish(&chunks[0].builder);
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static void * __hexfont_parallel_worker(void *arg) {
+    __hexfont_parallel_chunk * const chunk = arg;
+
+    if (!__hexfont_builder_init(&chunk->builder, chunk->glyph_height)) {
+        return NULL;
+    }
+
+    const char *line = chunk->start;
+    while (line < chunk->end) {
+        const char * const newline = memchr(line, '\n', chunk->end - line);
+        const char * const line_end = (newline) ? newline : chunk->end;
+
+        // The line ending counts towards the longest line, as it does
+        // when the file is fed to a hexfont_loader
+        if (!__hexfont_builder_add_line(&chunk->builder, line, line_end - line + (newline != NULL))) {
+            __hexfont_builder_abort(&chunk->builder);
+            return NULL;
+        }
+        line = line_end + 1;
+    }
+
+    chunk->ok = true;
+    return NULL;
+}
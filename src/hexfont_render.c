@@ -0,0 +1,433 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "hexfont.h"
+#include "hexfont_atlas.h"
+#include "hexfont_bits.h"
+#include "hexfont_color.h"
+#include "hexfont_list.h"
+#include "hexfont_render.h"
+#include "hexfont_utf8.h"
+
+// Number of source pixels blitted in one step
+#define HEXFONT_RENDER_CHUNK_BITS 32
+
+// Scaled glyphs up to this many bytes are built in a buffer on the stack
+#define HEXFONT_RENDER_SCALE_STACK_BUFFER 2048
+
+// Codepoints decoded and looked up at a time
+#define HEXFONT_RENDER_BATCH 64
+
+/**
+ * Drawable area, the clip rectangle intersected with the bitmap or surface
+  */
+typedef struct __hexfont_render_clip {
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+
+} __hexfont_render_clip;
+
+static void __hexfont_render_clip_init(__hexfont_render_clip * const out, const int32_t width, const int32_t height, const hexfont_rect * const clip);
+static const int32_t __hexfont_render_text(hexfont * const font, hexfont_list * const fonts, hexfont_bitmap * const bitmap, hexfont_surface * const surface, const hexfont_colors * const colors, const hexfont_rect * const clip, int32_t x, int32_t y, const unsigned int scale, const char *text);
+static const int32_t __hexfont_render_measure(hexfont * const font, hexfont_list * const fonts, const char *text, hexfont_line * const lines, const size_t max_lines, size_t * const line_count);
+static void __hexfont_render_scaled(const hexfont_bitmap * const bitmap, const __hexfont_render_clip * const clip, const hexfont_character * const c, const unsigned int scale, const int32_t x, const int32_t y);
+static void __hexfont_render_blit(const hexfont_bitmap * const bitmap, const __hexfont_render_clip * const clip, const uint8_t * const rows, const size_t row_bytes, const int32_t width, const int32_t height, const int32_t x, const int32_t y);
+static void __hexfont_render_blit_color(const hexfont_surface * const surface, const __hexfont_render_clip * const clip, const hexfont_character * const c, const __hexfont_color_pen * const pen, const int32_t x, const int32_t y);
+static inline const uint32_t __hexfont_render_load(const uint8_t * const row, const size_t row_bytes, const int32_t bit);
+
+
+const int32_t hexfont_render_utf8(hexfont * const font, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const char *text) {
+    return __hexfont_render_text(font, NULL, bitmap, NULL, NULL, clip, x, y, 1, text);
+}
+
+const int32_t hexfont_list_render_utf8(hexfont_list * const fonts, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const char *text) {
+    return __hexfont_render_text(NULL, fonts, bitmap, NULL, NULL, clip, x, y, 1, text);
+}
+
+const int32_t hexfont_render_utf8_scaled(hexfont * const font, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const unsigned int scale, const char *text) {
+    return __hexfont_render_text(font, NULL, bitmap, NULL, NULL, clip, x, y, scale, text);
+}
+
+const int32_t hexfont_list_render_utf8_scaled(hexfont_list * const fonts, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const unsigned int scale, const char *text) {
+    return __hexfont_render_text(NULL, fonts, bitmap, NULL, NULL, clip, x, y, scale, text);
+}
+
+const int32_t hexfont_render_utf8_color(hexfont * const font, hexfont_surface * const surface, const hexfont_rect * const clip, int32_t x, int32_t y, const hexfont_colors * const colors, const char *text) {
+    return __hexfont_render_text(font, NULL, NULL, surface, colors, clip, x, y, 1, text);
+}
+
+const int32_t hexfont_list_render_utf8_color(hexfont_list * const fonts, hexfont_surface * const surface, const hexfont_rect * const clip, int32_t x, int32_t y, const hexfont_colors * const colors, const char *text) {
+    return __hexfont_render_text(NULL, fonts, NULL, surface, colors, clip, x, y, 1, text);
+}
+
+const int32_t hexfont_atlas_render_utf8(const hexfont_atlas * const atlas, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, int32_t x, int32_t y, const char *text) {
+    __hexfont_render_clip bounds;
+    __hexfont_render_clip_init(&bounds, bitmap->width, bitmap->height, clip);
+
+    const int32_t line_x = x;
+    const int32_t height = atlas->glyph_height;
+    uint32_t codepoints[HEXFONT_RENDER_BATCH];
+    uint32_t entries[HEXFONT_RENDER_BATCH];
+    const char * const end = text + strlen(text);
+    const char *p = text;
+    while (p < end) {
+        size_t consumed;
+        const size_t n = hexfont_atlas_find_utf8(atlas, p, end - p, entries, codepoints, HEXFONT_RENDER_BATCH, &consumed);
+        p += consumed;
+
+        size_t i = 0;
+        for (i=0; i<n; i++) {
+            if (codepoints[i] == '\n') {
+                x = line_x;
+                y += height;
+                continue;
+            }
+
+            const uint32_t entry = entries[i];
+            if (entry == HEXFONT_ATLAS_NONE) {
+                continue;
+            }
+
+            const uint32_t offset = atlas->offsets[entry];
+            const size_t row_bytes = (height > 0) ? (atlas->offsets[entry + 1] - offset) / height : 0;
+            __hexfont_render_blit(bitmap, &bounds, atlas->data + offset, row_bytes, atlas->widths[entry], height, x, y);
+            x += atlas->widths[entry] + HEXFONT_RENDER_LETTER_SPACING;
+        }
+    }
+
+    return x;
+}
+
+const int32_t hexfont_measure_utf8(hexfont * const font, const char *text, hexfont_line * const lines, const size_t max_lines, size_t * const line_count) {
+    return __hexfont_render_measure(font, NULL, text, lines, max_lines, line_count);
+}
+
+const int32_t hexfont_list_measure_utf8(hexfont_list * const fonts, const char *text, hexfont_line * const lines, const size_t max_lines, size_t * const line_count) {
+    return __hexfont_render_measure(NULL, fonts, text, lines, max_lines, line_count);
+}
+
+void hexfont_render_character(hexfont_character * const c, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, const int32_t x, const int32_t y) {
+    __hexfont_render_clip bounds;
+    __hexfont_render_clip_init(&bounds, bitmap->width, bitmap->height, clip);
+
+    __hexfont_render_blit(bitmap, &bounds, c->glyph, c->glyph_len / c->height, c->width, c->height, x, y);
+}
+
+void hexfont_render_character_scaled(hexfont_character * const c, hexfont_bitmap * const bitmap, const hexfont_rect * const clip, const int32_t x, const int32_t y, const unsigned int scale) {
+    __hexfont_render_clip bounds;
+    __hexfont_render_clip_init(&bounds, bitmap->width, bitmap->height, clip);
+
+    __hexfont_render_scaled(bitmap, &bounds, c, scale, x, y);
+}
+
+void hexfont_render_character_color(hexfont_character * const c, hexfont_surface * const surface, const hexfont_rect * const clip, const int32_t x, const int32_t y, const hexfont_colors * const colors) {
+    __hexfont_render_clip bounds;
+    __hexfont_render_clip_init(&bounds, surface->width, surface->height, clip);
+
+    __hexfont_color_pen pen;
+    __hexfont_color_pen_init(&pen, surface->format, colors);
+
+    __hexfont_render_blit_color(surface, &bounds, c, &pen, x, y);
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static void __hexfont_render_clip_init(__hexfont_render_clip * const out, const int32_t width, const int32_t height, const hexfont_rect * const clip) {
+    out->x0 = 0;
+    out->y0 = 0;
+    out->x1 = width;
+    out->y1 = height;
+
+    if (clip) {
+        if (clip->x > out->x0) {
+            out->x0 = clip->x;
+        }
+        if (clip->y > out->y0) {
+            out->y0 = clip->y;
+        }
+        if (clip->x + clip->width < out->x1) {
+            out->x1 = clip->x + clip->width;
+        }
+        if (clip->y + clip->height < out->y1) {
+            out->y1 = clip->y + clip->height;
+        }
+    }
+}
+
+/**
+ * Draw onto the bitmap, or with colors onto the surface when bitmap is NULL
+*/
+static const int32_t __hexfont_render_text(hexfont * const font, hexfont_list * const fonts, hexfont_bitmap * const bitmap, hexfont_surface * const surface, const hexfont_colors * const colors, const hexfont_rect * const clip, int32_t x, int32_t y, const unsigned int scale, const char *text) {
+    __hexfont_render_clip bounds;
+    __hexfont_color_pen pen;
+    if (bitmap) {
+        __hexfont_render_clip_init(&bounds, bitmap->width, bitmap->height, clip);
+    }
+    else {
+        __hexfont_render_clip_init(&bounds, surface->width, surface->height, clip);
+        __hexfont_color_pen_init(&pen, surface->format, colors);
+    }
+
+    // Lines are spaced by the height of the first font
+    const int32_t line_x = x;
+    const hexfont * const first = (font) ? font : (fonts) ? fonts->item : NULL;
+    const int32_t line_height = (first) ? first->glyph_height * (int32_t)scale : 0;
+
+    // The text is decoded and looked up a batch at a time, characters are
+    // only fetched as they are drawn since a compact font reuses its buffer
+    uint32_t codepoints[HEXFONT_RENDER_BATCH];
+    uint32_t numbers[HEXFONT_RENDER_BATCH];
+    const char * const end = text + strlen(text);
+    const char *p = text;
+    while (p < end) {
+        size_t consumed;
+        const size_t n = __hexfont_utf8_decode_batch(p, end - p, codepoints, HEXFONT_RENDER_BATCH, &consumed);
+        p += consumed;
+        if (font) {
+            __hexfont_find_batch(font, codepoints, numbers, n);
+        }
+
+        size_t i = 0;
+        for (i=0; i<n; i++) {
+            if (codepoints[i] == '\n') {
+                x = line_x;
+                y += line_height;
+                continue;
+            }
+
+            hexfont_character * const c = (font == NULL) ?
+                    hexfont_list_get(fonts, codepoints[i]) :
+                    (numbers[i]) ? __hexfont_character_at(font, numbers[i] - 1) : NULL;
+            if (c == NULL) {
+                continue;
+            }
+
+            if (bitmap == NULL) {
+                __hexfont_render_blit_color(surface, &bounds, c, &pen, x, y);
+            }
+            else if (scale == 1) {
+                __hexfont_render_blit(bitmap, &bounds, c->glyph, c->glyph_len / c->height, c->width, c->height, x, y);
+            }
+            else {
+                __hexfont_render_scaled(bitmap, &bounds, c, scale, x, y);
+            }
+            x += (c->width + HEXFONT_RENDER_LETTER_SPACING) * (int32_t)scale;
+        }
+    }
+
+    return x;
+}
+
+static const int32_t __hexfont_render_measure(hexfont * const font, hexfont_list * const fonts, const char *text, hexfont_line * const lines, const size_t max_lines, size_t * const line_count) {
+    const char * const end = text + strlen(text);
+    const char *p = text;
+    const char *line_start = text;
+    int32_t x = 0;
+    int32_t widest = 0;
+    size_t count = 0;
+
+    while (true) {
+        const char * const at = p;
+        const uint32_t codepoint = (p < end) ? __hexfont_utf8_next(&p, end) : '\n';
+        if (codepoint == '\n') {
+            if (lines && count < max_lines) {
+                lines[count].offset = line_start - text;
+                lines[count].length = at - line_start;
+                lines[count].width = x;
+            }
+            count++;
+            if (x > widest) {
+                widest = x;
+            }
+
+            // The end of the text finishes the last line
+            if (at == end) {
+                break;
+            }
+            line_start = p;
+            x = 0;
+            continue;
+        }
+
+        const hexfont_metrics * const m = (font) ?
+                hexfont_get_metrics(font, codepoint) :
+                hexfont_list_get_metrics(fonts, codepoint);
+        if (m) {
+            x += m->advance;
+        }
+    }
+
+    if (line_count) {
+        *line_count = count;
+    }
+
+    return widest;
+}
+
+/**
+ * Spread the glyph out by scale into a buffer with whole rows repeated,
+ * then blit that like any other glyph
+*/
+static void __hexfont_render_scaled(const hexfont_bitmap * const bitmap, const __hexfont_render_clip * const clip, const hexfont_character * const c, const unsigned int scale, const int32_t x, const int32_t y) {
+    if (scale == 0) {
+        return;
+    }
+
+    const size_t row_bytes = c->glyph_len / c->height;
+    const size_t len = c->glyph_len * scale * scale;
+
+    uint8_t buffer[HEXFONT_RENDER_SCALE_STACK_BUFFER];
+    uint8_t * const rows = (len <= sizeof(buffer)) ? buffer : malloc(len);
+    if (rows == NULL) {
+        return;
+    }
+
+    __hexfont_bits_scale(rows, c->glyph, row_bytes, c->height, scale);
+    __hexfont_render_blit(bitmap, clip, rows, row_bytes * scale, c->width * (int32_t)scale, c->height * (int32_t)scale, x, y);
+
+    if (rows != buffer) {
+        free(rows);
+    }
+}
+
+/**
+ * OR a packed 1 bit per pixel image into the bitmap with its top left at (x, y).
+ * Each source row is loaded up to 32 pixels at a time, shifted into
+ * position and OR-ed into at most 5 destination bytes.
+*/
+static void __hexfont_render_blit(const hexfont_bitmap * const bitmap, const __hexfont_render_clip * const clip, const uint8_t * const rows, const size_t row_bytes, const int32_t width, const int32_t height, const int32_t x, const int32_t y) {
+    // Work out which part of the source is visible
+    const int32_t width_bits = (row_bytes * HEXFONT_BYTE_WIDTH < (size_t)width) ?
+                                    (int32_t)(row_bytes * HEXFONT_BYTE_WIDTH) : width;
+    const int32_t sx0 = (clip->x0 > x) ? clip->x0 - x : 0;
+    const int32_t sx1 = (clip->x1 - x < width_bits) ? clip->x1 - x : width_bits;
+    const int32_t sy0 = (clip->y0 > y) ? clip->y0 - y : 0;
+    const int32_t sy1 = (clip->y1 - y < height) ? clip->y1 - y : height;
+    if (sx0 >= sx1 || sy0 >= sy1) {
+        return;
+    }
+
+    int32_t sy = 0;
+    for (sy=sy0; sy<sy1; sy++) {
+        const uint8_t * const src = rows + sy * row_bytes;
+        uint8_t * const dst = bitmap->data + (size_t)(y + sy) * bitmap->stride;
+
+        int32_t sx = sx0;
+        while (sx < sx1) {
+            const int32_t n = (sx1 - sx < HEXFONT_RENDER_CHUNK_BITS) ? sx1 - sx : HEXFONT_RENDER_CHUNK_BITS;
+            const uint32_t bits = __hexfont_render_load(src, row_bytes, sx) &
+                                  (uint32_t)(0xffffffff00000000ULL >> n);
+
+            // Line the pixels up with the destination bytes
+            const int32_t dx = x + sx;
+            const int32_t shift = dx & (HEXFONT_BYTE_WIDTH - 1);
+            const uint64_t word = (uint64_t)bits << (32 - shift);
+            uint8_t * const d = dst + (dx >> 3);
+
+            d[0] |= (uint8_t)(word >> 56);
+            if (shift + n > 8) {
+                d[1] |= (uint8_t)(word >> 48);
+            }
+            if (shift + n > 16) {
+                d[2] |= (uint8_t)(word >> 40);
+            }
+            if (shift + n > 24) {
+                d[3] |= (uint8_t)(word >> 32);
+            }
+            if (shift + n > 32) {
+                d[4] |= (uint8_t)(word >> 24);
+            }
+
+            sx += n;
+        }
+    }
+}
+
+/**
+ * Expand a character into colored pixels with its top left at (x, y).
+ * Each source row is loaded up to 32 pixels at a time and written out as
+ * a span. An opaque background covers the letter spacing as well.
+*/
+static void __hexfont_render_blit_color(const hexfont_surface * const surface, const __hexfont_render_clip * const clip, const hexfont_character * const c, const __hexfont_color_pen * const pen, const int32_t x, const int32_t y) {
+    const size_t row_bytes = c->glyph_len / c->height;
+    const int32_t width = c->width + ((pen->transparent) ? 0 : HEXFONT_RENDER_LETTER_SPACING);
+    const int32_t height = c->height;
+
+    // Work out which part of the cell is visible
+    const int32_t sx0 = (clip->x0 > x) ? clip->x0 - x : 0;
+    const int32_t sx1 = (clip->x1 - x < width) ? clip->x1 - x : width;
+    const int32_t sy0 = (clip->y0 > y) ? clip->y0 - y : 0;
+    const int32_t sy1 = (clip->y1 - y < height) ? clip->y1 - y : height;
+    if (sx0 >= sx1 || sy0 >= sy1) {
+        return;
+    }
+
+    int32_t sy = 0;
+    for (sy=sy0; sy<sy1; sy++) {
+        const uint8_t * const src = c->glyph + sy * row_bytes;
+        uint8_t * const dst = surface->data + (size_t)(y + sy) * surface->stride;
+
+        // Pixels past the glyph's width are clear, so the spacing comes out as background
+        int32_t sx = sx0;
+        while (sx < sx1) {
+            const int32_t n = (sx1 - sx < HEXFONT_COLOR_SPAN_BITS) ? sx1 - sx : HEXFONT_COLOR_SPAN_BITS;
+            const uint32_t bits = __hexfont_render_load(src, row_bytes, sx);
+
+            __hexfont_color_span(dst + (size_t)(x + sx) * pen->pixel_bytes, pen, bits, n);
+            sx += n;
+        }
+    }
+}
+
+/**
+ * The 32 pixels of a row starting at pixel bit, MSB first, zero beyond the row
+*/
+static inline const uint32_t __hexfont_render_load(const uint8_t * const row, const size_t row_bytes, const int32_t bit) {
+    const size_t byte = bit >> 3;
+
+    // Whole glyph rows of up to 4 bytes are the common case
+    if (bit == 0 && row_bytes <= 4) {
+        switch (row_bytes) {
+            case 1:
+                return (uint32_t)row[0] << 24;
+            case 2:
+                return ((uint32_t)row[0] << 24) | ((uint32_t)row[1] << 16);
+            case 3:
+                return ((uint32_t)row[0] << 24) | ((uint32_t)row[1] << 16) | ((uint32_t)row[2] << 8);
+            case 4:
+                return ((uint32_t)row[0] << 24) | ((uint32_t)row[1] << 16) | ((uint32_t)row[2] << 8) | row[3];
+        }
+    }
+
+    uint64_t v = 0;
+    size_t i = 0;
+    for (i=0; i<5; i++) {
+        v = (v << 8) | ((byte + i < row_bytes) ? row[byte + i] : 0);
+    }
+
+    return (uint32_t)(v >> (8 - (bit & 7)));
+}
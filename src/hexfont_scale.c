@@ -0,0 +1,148 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "hexfont.h"
+#include "hexfont_arena.h"
+#include "hexfont_bits.h"
+#include "hexfont_scale.h"
+
+/**
+ * Scaled glyphs go into the arena, which is guarded by the lock,
+ * slots are published once they are complete
+  */
+struct hexfont_scale_cache {
+    hexfont *font;
+    unsigned int scale;
+    hexfont_character *slots;
+    __hexfont_arena *arena;
+    pthread_mutex_t lock;
+};
+
+static hexfont_character * const __hexfont_scale_cache_fill(hexfont_scale_cache * const cache, const uint32_t index);
+
+
+const size_t hexfont_scale_size(const hexfont_character * const c, const unsigned int scale) {
+    return c->glyph_len * scale * scale;
+}
+
+const bool hexfont_scale_character(const hexfont_character * const c, const unsigned int scale, uint8_t * const out, hexfont_character * const result) {
+    if (scale == 0 ||
+        (size_t)c->width * scale > UINT8_MAX ||
+        (size_t)c->height * scale > UINT8_MAX) {
+        return false;
+    }
+
+    __hexfont_bits_scale(out, c->glyph, c->glyph_len / c->height, c->height, scale);
+
+    result->codepoint = c->codepoint;
+    result->glyph = out;
+    result->glyph_len = hexfont_scale_size(c, scale);
+    result->width = c->width * scale;
+    result->height = c->height * scale;
+
+    return true;
+}
+
+hexfont_scale_cache * const hexfont_scale_cache_create(hexfont * const font, const unsigned int scale) {
+    // Every character of the font is this tall, so none of them would scale
+    if (scale == 0 || (size_t)font->glyph_height * scale > UINT8_MAX) {
+        return NULL;
+    }
+
+    hexfont_scale_cache * const cache = malloc(sizeof(hexfont_scale_cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->font = font;
+    cache->scale = scale;
+    cache->slots = calloc(font->length > 0 ? font->length : 1, sizeof(hexfont_character));
+    cache->arena = __hexfont_arena_create();
+    pthread_mutex_init(&cache->lock, NULL);
+    if (cache->slots == NULL || cache->arena == NULL) {
+        hexfont_scale_cache_destroy(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+hexfont_character * const hexfont_scale_cache_get(hexfont_scale_cache * const cache, const uint32_t codepoint) {
+    const uint32_t number = __hexfont_find(cache->font, codepoint);
+    if (number == 0) {
+        return NULL;
+    }
+
+    hexfont_character * const slot = &cache->slots[number - 1];
+    if (__atomic_load_n(&slot->glyph, __ATOMIC_ACQUIRE) != NULL) {
+        return slot;
+    }
+
+    return __hexfont_scale_cache_fill(cache, number - 1);
+}
+
+void hexfont_scale_cache_destroy(hexfont_scale_cache * const cache) {
+    pthread_mutex_destroy(&cache->lock);
+    __hexfont_arena_destroy(cache->arena);
+    free(cache->slots);
+    free(cache);
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static hexfont_character * const __hexfont_scale_cache_fill(hexfont_scale_cache * const cache, const uint32_t index) {
+    hexfont_character * const slot = &cache->slots[index];
+
+    pthread_mutex_lock(&cache->lock);
+
+    // Another thread may have got here first
+    if (slot->glyph == NULL) {
+        hexfont_character * const c = __hexfont_character_at(cache->font, index);
+        const size_t len = (c) ? hexfont_scale_size(c, cache->scale) : 0;
+        uint8_t * const glyph = (len > 0) ? __hexfont_arena_alloc(cache->arena, len, 1) : NULL;
+
+        // A glyph which is too wide to scale gives its room back, as it
+        // is tried again on every lookup
+        hexfont_character result;
+        if (glyph == NULL || !hexfont_scale_character(c, cache->scale, glyph, &result)) {
+            if (glyph) {
+                __hexfont_arena_free_last(cache->arena, glyph, len);
+            }
+            pthread_mutex_unlock(&cache->lock);
+            return NULL;
+        }
+
+        slot->codepoint = result.codepoint;
+        slot->glyph_len = result.glyph_len;
+        slot->width = result.width;
+        slot->height = result.height;
+        __atomic_store_n(&slot->glyph, result.glyph, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return slot;
+}
@@ -0,0 +1,124 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include "hexfont.h"
+#include "hexfont_shared.h"
+
+// Keeps the reader counts apart so that they don't share a cache line
+#define HEXFONT_SHARED_CACHE_LINE 64
+
+typedef struct __hexfont_shared_count {
+    uint64_t readers;
+    uint8_t pad[HEXFONT_SHARED_CACHE_LINE - sizeof(uint64_t)];
+
+} __hexfont_shared_count;
+
+/**
+ * Readers are counted against the parity of the epoch they saw.
+ * A writer publishes the new font, moves the epoch on and then waits for
+ * the readers of the old parity to leave. Anyone who arrives later sees
+ * the new epoch and so the new font, which makes the old one safe to free.
+ * Writers are kept apart by the lock.
+  */
+struct hexfont_shared {
+    __hexfont_shared_count counts[2];
+    hexfont *font;
+    uint64_t epoch;
+    pthread_mutex_t lock;
+};
+
+
+hexfont_shared * const hexfont_shared_create(hexfont * const font) {
+    hexfont_shared * const shared = malloc(sizeof(hexfont_shared));
+    if (shared == NULL) {
+        return NULL;
+    }
+
+    shared->counts[0].readers = 0;
+    shared->counts[1].readers = 0;
+    shared->font = font;
+    shared->epoch = 0;
+    pthread_mutex_init(&shared->lock, NULL);
+
+    return shared;
+}
+
+hexfont * const hexfont_shared_acquire(hexfont_shared * const shared, hexfont_shared_ref * const ref) {
+    // Count ourselves in, unless a writer moved the epoch on in the meantime
+    for (;;) {
+        const uint64_t epoch = __atomic_load_n(&shared->epoch, __ATOMIC_SEQ_CST);
+        ref->slot = epoch & 1;
+        __atomic_add_fetch(&shared->counts[ref->slot].readers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&shared->epoch, __ATOMIC_SEQ_CST) == epoch) {
+            break;
+        }
+        __atomic_sub_fetch(&shared->counts[ref->slot].readers, 1, __ATOMIC_SEQ_CST);
+    }
+
+    ref->font = __atomic_load_n(&shared->font, __ATOMIC_SEQ_CST);
+    return ref->font;
+}
+
+void hexfont_shared_release(hexfont_shared * const shared, hexfont_shared_ref * const ref) {
+    __atomic_sub_fetch(&shared->counts[ref->slot].readers, 1, __ATOMIC_RELEASE);
+    ref->font = NULL;
+}
+
+void hexfont_shared_replace(hexfont_shared * const shared, hexfont * const font) {
+    pthread_mutex_lock(&shared->lock);
+
+    hexfont * const old = __atomic_exchange_n(&shared->font, font, __ATOMIC_SEQ_CST);
+    const uint64_t epoch = __atomic_add_fetch(&shared->epoch, 1, __ATOMIC_SEQ_CST) - 1;
+
+    // Readers of the old parity may have the old font
+    while (__atomic_load_n(&shared->counts[epoch & 1].readers, __ATOMIC_ACQUIRE) != 0) {
+        sched_yield();
+    }
+
+    pthread_mutex_unlock(&shared->lock);
+
+    if (old) {
+        hexfont_destroy(old);
+    }
+}
+
+const bool hexfont_shared_reload(hexfont_shared * const shared, const char *file, const uint8_t glyph_height, const unsigned int flags) {
+    hexfont * const font = hexfont_load_flags(file, glyph_height, flags);
+    if (font == NULL) {
+        return false;
+    }
+
+    hexfont_shared_replace(shared, font);
+    return true;
+}
+
+void hexfont_shared_destroy(hexfont_shared * const shared) {
+    pthread_mutex_destroy(&shared->lock);
+    if (shared->font) {
+        hexfont_destroy(shared->font);
+    }
+    free(shared);
+}
@@ -0,0 +1,54 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_SOURCE_H__
+#define __HEXFONT_SOURCE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hexfont.h"
+
+/**
+ * Backing store of a font whose characters are not held in its
+ * characters array, but produced on demand by index.
+ * Each kind of source embeds this as its first member.
+  */
+typedef struct __hexfont_source {
+    // Find the character at an index of the font, or NULL
+    hexfont_character * const (*get)(hexfont * const font, const uint32_t index);
+
+    // Release the source and everything it owns
+    void (*destroy)(struct __hexfont_source * const source);
+
+    // Fill in the glyph and table figures of hexfont_get_memory_stats, may be NULL
+    void (*stats)(hexfont * const font, hexfont_memory_stats * const stats);
+
+} __hexfont_source;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_SOURCE_H__
@@ -0,0 +1,126 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_stats.h"
+
+
+__hexfont_counters * const __hexfont_counters_create() {
+#ifdef HEXFONT_STATS
+    return calloc(1, sizeof(__hexfont_counters));
+#else
+    return NULL;
+#endif
+}
+
+void hexfont_get_stats(hexfont * const font, hexfont_stats * const stats) {
+    memset(stats, 0, sizeof(hexfont_stats));
+    stats->characters = font->length;
+    stats->directory_length = font->directory_length;
+
+    // Page 0 is the empty one shared by blocks without characters. Filled
+    // slots are counted, the length also has every extra line for a
+    // codepoint which is in the file more than once
+    uint64_t used = 0;
+    uint32_t block = 0;
+    for (block=0; block<font->directory_length; block++) {
+        const uint32_t page = font->directory[block];
+        if (page == 0) {
+            continue;
+        }
+
+        uint32_t filled = 0;
+        uint32_t i = 0;
+        for (i=0; i<HEXFONT_PAGE_SIZE; i++) {
+            filled += (font->pages[((size_t)page << HEXFONT_PAGE_BITS) | i] != 0);
+        }
+
+        used += filled;
+        stats->pages++;
+        if (filled > stats->fullest_page) {
+            stats->fullest_page = filled;
+        }
+    }
+    if (stats->pages > 0) {
+        stats->occupancy = (double)used / ((double)stats->pages * HEXFONT_PAGE_SIZE);
+    }
+
+    const __hexfont_counters * const counters = font->counters;
+    if (counters == NULL) {
+        return;
+    }
+
+    stats->counted = true;
+    stats->lookups = __atomic_load_n(&counters->lookups, __ATOMIC_RELAXED);
+    stats->misses = __atomic_load_n(&counters->misses, __ATOMIC_RELAXED);
+    stats->list_hits = __atomic_load_n(&counters->list_hits, __ATOMIC_RELAXED);
+    stats->list_misses = __atomic_load_n(&counters->list_misses, __ATOMIC_RELAXED);
+    stats->decodes = __atomic_load_n(&counters->decodes, __ATOMIC_RELAXED);
+    stats->parse_ns = counters->parse_ns;
+    stats->index_ns = counters->index_ns;
+    stats->compact_ns = counters->compact_ns;
+}
+
+void hexfont_reset_stats(hexfont * const font) {
+    __hexfont_counters * const counters = font->counters;
+    if (counters == NULL) {
+        return;
+    }
+
+    __atomic_store_n(&counters->lookups, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&counters->misses, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&counters->list_hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&counters->list_misses, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&counters->decodes, 0, __ATOMIC_RELAXED);
+}
+
+const bool hexfont_write_stats_json(hexfont * const font, FILE *fp) {
+    hexfont_stats stats;
+    hexfont_memory_stats memory;
+    hexfont_get_stats(font, &stats);
+    hexfont_get_memory_stats(font, &memory);
+
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"characters\": %u,\n", stats.characters);
+    fprintf(fp, "  \"directory_length\": %u,\n", stats.directory_length);
+    fprintf(fp, "  \"pages\": %u,\n", stats.pages);
+    fprintf(fp, "  \"fullest_page\": %u,\n", stats.fullest_page);
+    fprintf(fp, "  \"occupancy\": %.4f,\n", stats.occupancy);
+    fprintf(fp, "  \"counted\": %s,\n", (stats.counted) ? "true" : "false");
+    fprintf(fp, "  \"lookups\": %llu,\n", (unsigned long long)stats.lookups);
+    fprintf(fp, "  \"misses\": %llu,\n", (unsigned long long)stats.misses);
+    fprintf(fp, "  \"list_hits\": %llu,\n", (unsigned long long)stats.list_hits);
+    fprintf(fp, "  \"list_misses\": %llu,\n", (unsigned long long)stats.list_misses);
+    fprintf(fp, "  \"decodes\": %llu,\n", (unsigned long long)stats.decodes);
+    fprintf(fp, "  \"parse_ns\": %llu,\n", (unsigned long long)stats.parse_ns);
+    fprintf(fp, "  \"index_ns\": %llu,\n", (unsigned long long)stats.index_ns);
+    fprintf(fp, "  \"compact_ns\": %llu,\n", (unsigned long long)stats.compact_ns);
+    fprintf(fp, "  \"memory\": {\"unique_glyphs\": %u, \"glyph_bytes\": %zu, \"saved_bytes\": %zu, \"arena_bytes\": %zu, \"table_bytes\": %zu}\n",
+            memory.unique_glyphs, memory.glyph_bytes, memory.saved_bytes, memory.arena_bytes, memory.table_bytes);
+    fprintf(fp, "}\n");
+
+    return !ferror(fp);
+}
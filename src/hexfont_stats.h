@@ -0,0 +1,53 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_STATS_H__
+#define __HEXFONT_STATS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <time.h>
+#include "hexfont.h"
+
+// Zeroed counters for a new font, or NULL unless built with HEXFONT_STATS
+__hexfont_counters * const __hexfont_counters_create();
+
+// Monotonic time in ns for the load timings, 0 unless built with HEXFONT_STATS
+static inline const uint64_t __hexfont_stats_now() {
+#ifdef HEXFONT_STATS
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_STATS_H__
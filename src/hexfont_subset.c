@@ -0,0 +1,265 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_subset.h"
+#include "hexfont_utf8.h"
+
+// One bit for each codepoint up to HEXFONT_MAX_CODEPOINT
+#define HEXFONT_SUBSET_WORD_BITS 64
+#define HEXFONT_SUBSET_WORDS ((HEXFONT_MAX_CODEPOINT / HEXFONT_SUBSET_WORD_BITS) + 1)
+
+// Bytes of a corpus read at a time
+#define HEXFONT_SUBSET_CHUNK_SIZE (64 * 1024)
+
+// Longest UTF-8 sequence
+#define HEXFONT_SUBSET_MAX_SEQUENCE 4
+
+/**
+ * The set is a plain bitmap, which is small enough at 136KB to make
+ * adding a codepoint a single or.
+ * Malformed text decodes to the fallback, which is always in the set, so
+ * only a sequence split between two calls to hexfont_subset_add_utf8 needs
+ * any care, its start is kept in pending.
+  */
+struct hexfont_subset {
+    uint64_t bits[HEXFONT_SUBSET_WORDS];
+    char pending[HEXFONT_SUBSET_MAX_SEQUENCE];
+    size_t pending_len;
+};
+
+static inline void __hexfont_subset_set(hexfont_subset * const subset, const uint32_t codepoint);
+static inline const size_t __hexfont_subset_sequence_len(const char lead);
+static inline const bool __hexfont_subset_continues(const char *p, const char * const end);
+static const bool __hexfont_subset_write_character(FILE *fp, const hexfont_character * const c);
+
+
+hexfont_subset * const hexfont_subset_create() {
+    hexfont_subset * const subset = calloc(1, sizeof(hexfont_subset));
+    if (subset == NULL) {
+        return NULL;
+    }
+
+    __hexfont_subset_set(subset, HEXFONT_SUBSET_FALLBACK);
+
+    return subset;
+}
+
+void hexfont_subset_add(hexfont_subset * const subset, const uint32_t codepoint) {
+    if (codepoint <= HEXFONT_MAX_CODEPOINT) {
+        __hexfont_subset_set(subset, codepoint);
+    }
+}
+
+void hexfont_subset_add_range(hexfont_subset * const subset, const uint32_t first, const uint32_t last) {
+    const uint32_t end = (last < HEXFONT_MAX_CODEPOINT) ? last : HEXFONT_MAX_CODEPOINT;
+    uint32_t codepoint = first;
+
+    // Set the bits up to the first whole word one at a time, then a word at a time
+    while (codepoint <= end && codepoint % HEXFONT_SUBSET_WORD_BITS != 0) {
+        __hexfont_subset_set(subset, codepoint++);
+    }
+    while (codepoint <= end && end - codepoint >= HEXFONT_SUBSET_WORD_BITS - 1) {
+        subset->bits[codepoint / HEXFONT_SUBSET_WORD_BITS] = UINT64_MAX;
+        codepoint += HEXFONT_SUBSET_WORD_BITS;
+    }
+    while (codepoint <= end) {
+        __hexfont_subset_set(subset, codepoint++);
+    }
+}
+
+void hexfont_subset_add_utf8(hexfont_subset * const subset, const char * const text, const size_t len) {
+    const char *p = text;
+    const char * const end = text + len;
+
+    // Finish the sequence which was split off at the end of the last call
+    if (subset->pending_len > 0) {
+        const size_t sequence_len = __hexfont_subset_sequence_len(subset->pending[0]);
+        while (subset->pending_len < sequence_len && p < end &&
+               ((uint8_t)*p & 0xc0) == 0x80) {
+            subset->pending[subset->pending_len++] = *p++;
+        }
+        if (subset->pending_len < sequence_len && p == end) {
+            return;
+        }
+
+        // Whatever is left of a broken sequence would only be the fallback
+        const char *q = subset->pending;
+        __hexfont_subset_set(subset, __hexfont_utf8_next(&q, q + subset->pending_len));
+        subset->pending_len = 0;
+    }
+
+    while (p < end) {
+        // Most of a corpus is usually ASCII
+        const uint8_t b = (uint8_t)*p;
+        if (b < 0x80) {
+            __hexfont_subset_set(subset, b);
+            p++;
+            continue;
+        }
+
+        // Keep a sequence which runs off the end, unless it is already broken
+        const size_t sequence_len = __hexfont_subset_sequence_len(*p);
+        if (sequence_len > (size_t)(end - p) && __hexfont_subset_continues(p + 1, end)) {
+            memcpy(subset->pending, p, end - p);
+            subset->pending_len = end - p;
+            break;
+        }
+
+        __hexfont_subset_set(subset, __hexfont_utf8_next(&p, end));
+    }
+}
+
+const bool hexfont_subset_add_file(hexfont_subset * const subset, const char *file) {
+    FILE * const fp = fopen(file, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+
+    char * const chunk = malloc(HEXFONT_SUBSET_CHUNK_SIZE);
+    size_t read;
+    bool ok = (chunk != NULL);
+    while (ok && (read = fread(chunk, 1, HEXFONT_SUBSET_CHUNK_SIZE, fp)) > 0) {
+        hexfont_subset_add_utf8(subset, chunk, read);
+    }
+    ok = ok && !ferror(fp);
+
+    // A sequence cut off by the end of the file is malformed
+    subset->pending_len = 0;
+
+    free(chunk);
+    fclose(fp);
+
+    return ok;
+}
+
+const bool hexfont_subset_contains(const hexfont_subset * const subset, const uint32_t codepoint) {
+    if (codepoint > HEXFONT_MAX_CODEPOINT) {
+        return false;
+    }
+
+    return (subset->bits[codepoint / HEXFONT_SUBSET_WORD_BITS] >>
+                (codepoint % HEXFONT_SUBSET_WORD_BITS)) & 1;
+}
+
+const uint32_t hexfont_subset_count(const hexfont_subset * const subset) {
+    uint32_t count = 0;
+    size_t i = 0;
+    for (i=0; i<HEXFONT_SUBSET_WORDS; i++) {
+        count += __builtin_popcountll(subset->bits[i]);
+    }
+
+    return count;
+}
+
+void hexfont_subset_destroy(hexfont_subset * const subset) {
+    free(subset);
+}
+
+const bool hexfont_save_hex(hexfont * const font, const char *file) {
+    FILE * const fp = fopen(file, "w");
+    if (fp == NULL) {
+        return false;
+    }
+
+    // Walking the lookup table visits each codepoint once, in order
+    bool ok = true;
+    uint32_t block = 0;
+    for (block=0; ok && block<font->directory_length; block++) {
+        if (font->directory[block] == 0) {
+            continue;
+        }
+
+        uint32_t i = 0;
+        for (i=0; ok && i<HEXFONT_PAGE_SIZE; i++) {
+            const hexfont_character * const c = hexfont_get(font, (block << HEXFONT_PAGE_BITS) | i);
+            if (c) {
+                ok = __hexfont_subset_write_character(fp, c);
+            }
+        }
+    }
+
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok) {
+        remove(file);
+    }
+
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static inline void __hexfont_subset_set(hexfont_subset * const subset, const uint32_t codepoint) {
+    subset->bits[codepoint / HEXFONT_SUBSET_WORD_BITS] |=
+        (uint64_t)1 << (codepoint % HEXFONT_SUBSET_WORD_BITS);
+}
+
+/**
+ * Bytes in the sequence which starts with lead, anything which can't start
+ * one is taken as a single byte
+*/
+static inline const size_t __hexfont_subset_sequence_len(const char lead) {
+    const uint8_t b = (uint8_t)lead;
+    if ((b & 0xe0) == 0xc0) {
+        return 2;
+    }
+    if ((b & 0xf0) == 0xe0) {
+        return 3;
+    }
+    if ((b & 0xf8) == 0xf0) {
+        return 4;
+    }
+
+    return 1;
+}
+
+// Whether all of the bytes from p to end are continuation bytes
+static inline const bool __hexfont_subset_continues(const char *p, const char * const end) {
+    for (; p<end; p++) {
+        if (((uint8_t)*p & 0xc0) != 0x80) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Write one "codepoint:glyph" line, codepoints have at least four digits as in unifont
+static const bool __hexfont_subset_write_character(FILE *fp, const hexfont_character * const c) {
+    static const char digits[] = "0123456789ABCDEF";
+
+    if (fprintf(fp, "%04X:", (unsigned int)c->codepoint) < 0) {
+        return false;
+    }
+
+    size_t i = 0;
+    for (i=0; i<c->glyph_len; i++) {
+        putc(digits[c->glyph[i] >> 4], fp);
+        putc(digits[c->glyph[i] & 0x0f], fp);
+    }
+
+    return putc('\n', fp) != EOF;
+}
@@ -0,0 +1,403 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hexfont.h"
+#include "hexfont_list.h"
+#include "hexfont_render.h"
+#include "hexfont_term.h"
+
+// Room made in the output buffer to start with
+#define HEXFONT_TERM_INITIAL_CAPACITY 4096
+
+// Longest label or piece of sixel control data written at a time
+#define HEXFONT_TERM_CONTROL 64
+
+// Fewest repeats of a sixel which are written as a count
+#define HEXFONT_TERM_SIXEL_MIN_RUN 4
+
+/**
+ * Output being put together, failed is set once out of memory and
+ * everything after that is dropped
+  */
+typedef struct __hexfont_term_buffer {
+    char *data;
+    size_t len;
+    size_t capacity;
+    bool failed;
+
+} __hexfont_term_buffer;
+
+static const bool __hexfont_term_write_text(hexfont * const font, hexfont_list * const fonts, const char *text, const hexfont_term_mode mode, const int fd);
+static void __hexfont_term_encode(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap, const hexfont_term_mode mode);
+static void __hexfont_term_encode_ascii(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap);
+static void __hexfont_term_encode_half_blocks(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap);
+static void __hexfont_term_encode_braille(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap);
+static void __hexfont_term_encode_sixel(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap);
+static char * const __hexfont_term_reserve(__hexfont_term_buffer * const out, const size_t len);
+static const bool __hexfont_term_flush(__hexfont_term_buffer * const out, const int fd);
+static inline const unsigned int __hexfont_term_pixel(const hexfont_bitmap * const bitmap, const int32_t x, const int32_t y);
+
+
+const bool hexfont_term_write_bitmap(const hexfont_bitmap * const bitmap, const hexfont_term_mode mode, const int fd) {
+    __hexfont_term_buffer out = { NULL, 0, 0, false };
+    __hexfont_term_encode(&out, bitmap, mode);
+
+    return __hexfont_term_flush(&out, fd);
+}
+
+const bool hexfont_term_write_character(const hexfont_character * const c, const hexfont_term_mode mode, const int fd) {
+    // A glyph is already laid out like a bitmap, one row after another
+    hexfont_bitmap bitmap;
+    bitmap.data = (uint8_t *)c->glyph;
+    bitmap.stride = (c->height > 0) ? c->glyph_len / c->height : 0;
+    bitmap.width = c->width;
+    bitmap.height = c->height;
+
+    return hexfont_term_write_bitmap(&bitmap, mode, fd);
+}
+
+const bool hexfont_term_write_utf8(hexfont * const font, const char *text, const hexfont_term_mode mode, const int fd) {
+    return __hexfont_term_write_text(font, NULL, text, mode, fd);
+}
+
+const bool hexfont_list_term_write_utf8(hexfont_list * const fonts, const char *text, const hexfont_term_mode mode, const int fd) {
+    return __hexfont_term_write_text(NULL, fonts, text, mode, fd);
+}
+
+const bool hexfont_term_write_overview(hexfont * const font, const uint32_t first, const uint32_t columns, const uint32_t rows, const hexfont_term_mode mode, const int fd) {
+    // Cells are as wide as the widest character on the page
+    int32_t cell_width = 1;
+    uint32_t i = 0;
+    for (i=0; i<columns * rows && first + i <= HEXFONT_MAX_CODEPOINT; i++) {
+        const hexfont_metrics * const m = hexfont_get_metrics(font, first + i);
+        if (m && m->advance > cell_width) {
+            cell_width = m->advance;
+        }
+    }
+
+    hexfont_bitmap bitmap;
+    bitmap.width = cell_width * columns;
+    bitmap.height = font->glyph_height;
+    bitmap.stride = (bitmap.width + HEXFONT_BYTE_WIDTH - 1) / HEXFONT_BYTE_WIDTH;
+    bitmap.data = malloc(bitmap.stride * bitmap.height + 1);
+    if (bitmap.data == NULL) {
+        return false;
+    }
+
+    __hexfont_term_buffer out = { NULL, 0, 0, false };
+    uint32_t row = 0;
+    for (row=0; row<rows && first + row * columns <= HEXFONT_MAX_CODEPOINT; row++) {
+        const uint32_t row_first = first + row * columns;
+        char * const label = __hexfont_term_reserve(&out, HEXFONT_TERM_CONTROL);
+        if (label) {
+            out.len += snprintf(label, HEXFONT_TERM_CONTROL, "U+%04X\n", row_first);
+        }
+
+        memset(bitmap.data, 0, bitmap.stride * bitmap.height);
+        uint32_t column = 0;
+        for (column=0; column<columns && row_first + column <= HEXFONT_MAX_CODEPOINT; column++) {
+            hexfont_character * const c = hexfont_get(font, row_first + column);
+            if (c) {
+                hexfont_render_character(c, &bitmap, NULL, column * cell_width, 0);
+            }
+        }
+        __hexfont_term_encode(&out, &bitmap, mode);
+    }
+
+    free(bitmap.data);
+
+    return __hexfont_term_flush(&out, fd);
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static const bool __hexfont_term_write_text(hexfont * const font, hexfont_list * const fonts, const char *text, const hexfont_term_mode mode, const int fd) {
+    size_t line_count;
+    const int32_t width = (font) ?
+            hexfont_measure_utf8(font, text, NULL, 0, &line_count) :
+            hexfont_list_measure_utf8(fonts, text, NULL, 0, &line_count);
+
+    // Lines are spaced by the height of the first font, as they are drawn
+    const hexfont * const first = (font) ? font : (fonts) ? fonts->item : NULL;
+    hexfont_bitmap bitmap;
+    bitmap.width = width;
+    bitmap.height = (first) ? first->glyph_height * (int32_t)line_count : 0;
+    bitmap.stride = (bitmap.width + HEXFONT_BYTE_WIDTH - 1) / HEXFONT_BYTE_WIDTH;
+    bitmap.data = calloc(bitmap.stride * bitmap.height + 1, 1);
+    if (bitmap.data == NULL) {
+        return false;
+    }
+
+    if (font) {
+        hexfont_render_utf8(font, &bitmap, NULL, 0, 0, text);
+    }
+    else {
+        hexfont_list_render_utf8(fonts, &bitmap, NULL, 0, 0, text);
+    }
+
+    const bool ok = hexfont_term_write_bitmap(&bitmap, mode, fd);
+    free(bitmap.data);
+
+    return ok;
+}
+
+static void __hexfont_term_encode(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap, const hexfont_term_mode mode) {
+    if (bitmap->width <= 0 || bitmap->height <= 0) {
+        return;
+    }
+
+    switch (mode) {
+        case HEXFONT_TERM_HALF_BLOCKS:
+            __hexfont_term_encode_half_blocks(out, bitmap);
+            break;
+
+        case HEXFONT_TERM_BRAILLE:
+            __hexfont_term_encode_braille(out, bitmap);
+            break;
+
+        case HEXFONT_TERM_SIXEL:
+            __hexfont_term_encode_sixel(out, bitmap);
+            break;
+
+        default:
+            __hexfont_term_encode_ascii(out, bitmap);
+            break;
+    }
+}
+
+static void __hexfont_term_encode_ascii(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap) {
+    int32_t y = 0;
+    for (y=0; y<bitmap->height; y++) {
+        char *p = __hexfont_term_reserve(out, (size_t)bitmap->width * 2 + 1);
+        if (p == NULL) {
+            return;
+        }
+
+        int32_t x = 0;
+        for (x=0; x<bitmap->width; x++) {
+            *p++ = (__hexfont_term_pixel(bitmap, x, y)) ? '#' : '.';
+            *p++ = ' ';
+        }
+        *p++ = '\n';
+        out->len = p - out->data;
+    }
+}
+
+/**
+ * U+2580 upper half block, U+2584 lower half block and U+2588 full block,
+ * each 3 bytes of UTF-8, and a space for neither
+*/
+static void __hexfont_term_encode_half_blocks(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap) {
+    static const char blocks[4][3] = {
+        { ' ', 0, 0 },
+        { '\xe2', '\x96', '\x80' },
+        { '\xe2', '\x96', '\x84' },
+        { '\xe2', '\x96', '\x88' },
+    };
+
+    int32_t y = 0;
+    for (y=0; y<bitmap->height; y+=2) {
+        char *p = __hexfont_term_reserve(out, (size_t)bitmap->width * 3 + 1);
+        if (p == NULL) {
+            return;
+        }
+
+        int32_t x = 0;
+        for (x=0; x<bitmap->width; x++) {
+            const unsigned int cell = __hexfont_term_pixel(bitmap, x, y) |
+                                      (__hexfont_term_pixel(bitmap, x, y + 1) << 1);
+            memcpy(p, blocks[cell], 3);
+            p += (cell) ? 3 : 1;
+        }
+        *p++ = '\n';
+        out->len = p - out->data;
+    }
+}
+
+/**
+ * U+2800 to U+28FF, whose low 8 bits are the dots of a 2x4 cell, which
+ * are numbered down the left column then the right one, with the bottom
+ * row last
+*/
+static void __hexfont_term_encode_braille(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap) {
+    static const uint8_t dots[4][2] = {
+        { 0x01, 0x08 },
+        { 0x02, 0x10 },
+        { 0x04, 0x20 },
+        { 0x40, 0x80 },
+    };
+
+    const int32_t cells = (bitmap->width + 1) / 2;
+    int32_t y = 0;
+    for (y=0; y<bitmap->height; y+=4) {
+        char *p = __hexfont_term_reserve(out, (size_t)cells * 3 + 1);
+        if (p == NULL) {
+            return;
+        }
+
+        int32_t x = 0;
+        for (x=0; x<bitmap->width; x+=2) {
+            unsigned int bits = 0;
+            int32_t dy = 0;
+            for (dy=0; dy<4; dy++) {
+                bits |= (__hexfont_term_pixel(bitmap, x, y + dy)) ? dots[dy][0] : 0;
+                bits |= (__hexfont_term_pixel(bitmap, x + 1, y + dy)) ? dots[dy][1] : 0;
+            }
+            *p++ = '\xe2';
+            *p++ = 0xa0 | (bits >> 6);
+            *p++ = 0x80 | (bits & 0x3f);
+        }
+        *p++ = '\n';
+        out->len = p - out->data;
+    }
+}
+
+/**
+ * Each band of 6 rows is a run of characters, one per column, of '?'
+ * plus the column's pixels with the top one in bit 0. Runs of the same
+ * character are written as "!count" and the character.
+*/
+static void __hexfont_term_encode_sixel(__hexfont_term_buffer * const out, const hexfont_bitmap * const bitmap) {
+    char *p = __hexfont_term_reserve(out, HEXFONT_TERM_CONTROL);
+    if (p == NULL) {
+        return;
+    }
+
+    // Pixels which are clear are left transparent, color 1 is white
+    out->len += snprintf(p, HEXFONT_TERM_CONTROL,
+            "\033P0;1;0q\"1;1;%d;%d#1;2;100;100;100", (int)bitmap->width, (int)bitmap->height);
+
+    int32_t y = 0;
+    for (y=0; y<bitmap->height; y+=6) {
+        // A counted run is never longer than the columns it stands for
+        p = __hexfont_term_reserve(out, (size_t)bitmap->width + HEXFONT_TERM_CONTROL);
+        if (p == NULL) {
+            return;
+        }
+        *p++ = '#';
+        *p++ = '1';
+
+        int32_t x = 0;
+        while (x < bitmap->width) {
+            unsigned int bits = 0;
+            int32_t dy = 0;
+            for (dy=0; dy<6; dy++) {
+                bits |= __hexfont_term_pixel(bitmap, x, y + dy) << dy;
+            }
+
+            // Count the columns which are the same
+            int32_t run = 1;
+            while (x + run < bitmap->width) {
+                unsigned int next = 0;
+                for (dy=0; dy<6; dy++) {
+                    next |= __hexfont_term_pixel(bitmap, x + run, y + dy) << dy;
+                }
+                if (next != bits) {
+                    break;
+                }
+                run++;
+            }
+
+            const char sixel = '?' + bits;
+            if (run >= HEXFONT_TERM_SIXEL_MIN_RUN) {
+                p += sprintf(p, "!%d%c", (int)run, sixel);
+            }
+            else {
+                memset(p, sixel, run);
+                p += run;
+            }
+            x += run;
+        }
+        *p++ = '-';
+        out->len = p - out->data;
+    }
+
+    p = __hexfont_term_reserve(out, 2);
+    if (p) {
+        memcpy(p, "\033\\", 2);
+        out->len += 2;
+    }
+}
+
+/**
+ * Room for len more bytes at the end of the output, or NULL when out of
+ * memory. The caller moves len on by what it wrote.
+*/
+static char * const __hexfont_term_reserve(__hexfont_term_buffer * const out, const size_t len) {
+    if (out->failed) {
+        return NULL;
+    }
+
+    if (out->len + len > out->capacity) {
+        size_t capacity = (out->capacity > 0) ? out->capacity : HEXFONT_TERM_INITIAL_CAPACITY;
+        while (capacity < out->len + len) {
+            capacity *= 2;
+        }
+
+        char * const data = realloc(out->data, capacity);
+        if (data == NULL) {
+            out->failed = true;
+            return NULL;
+        }
+        out->data = data;
+        out->capacity = capacity;
+    }
+
+    return out->data + out->len;
+}
+
+// Write out everything in one go, unless interrupted, and free the buffer
+static const bool __hexfont_term_flush(__hexfont_term_buffer * const out, const int fd) {
+    bool ok = !out->failed;
+    size_t written = 0;
+    while (ok && written < out->len) {
+        const ssize_t n = write(fd, out->data + written, out->len - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        written += n;
+    }
+
+    free(out->data);
+    out->data = NULL;
+
+    return ok;
+}
+
+// Pixels outside of the bitmap are clear
+static inline const unsigned int __hexfont_term_pixel(const hexfont_bitmap * const bitmap, const int32_t x, const int32_t y) {
+    if (x >= bitmap->width || y >= bitmap->height) {
+        return 0;
+    }
+
+    return (bitmap->data[(size_t)y * bitmap->stride + (x >> 3)] >> (7 - (x & 7))) & 1;
+}
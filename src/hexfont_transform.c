@@ -0,0 +1,267 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "hexfont.h"
+#include "hexfont_arena.h"
+#include "hexfont_bits.h"
+#include "hexfont_transform.h"
+
+// Glyphs up to this many bytes are turned using a buffer on the stack
+#define HEXFONT_TRANSFORM_STACK_BUFFER 512
+
+/**
+ * Transformed data goes into the arena, which is guarded by the lock,
+ * slots are published once they are complete
+  */
+struct hexfont_transform_cache {
+    hexfont *font;
+    hexfont_transform transform;
+    hexfont_transformed *slots;
+    __hexfont_arena *arena;
+    pthread_mutex_t lock;
+};
+
+static void __hexfont_transform_geometry(const hexfont_character * const c, const hexfont_transform transform, hexfont_transformed * const result);
+static void __hexfont_transform_rotate(const hexfont_character * const c, const hexfont_transform transform, uint8_t * const out);
+static void __hexfont_transform_flip(const hexfont_character * const c, const hexfont_transform transform, uint8_t * const out);
+static const hexfont_transformed * const __hexfont_transform_cache_fill(hexfont_transform_cache * const cache, const uint32_t index);
+
+
+const size_t hexfont_transform_size(const hexfont_character * const c, const hexfont_transform transform) {
+    hexfont_transformed result;
+    __hexfont_transform_geometry(c, transform, &result);
+
+    return result.len;
+}
+
+void hexfont_transform_character(const hexfont_character * const c, const hexfont_transform transform, uint8_t * const out, hexfont_transformed * const result) {
+    __hexfont_transform_geometry(c, transform, result);
+    result->data = out;
+
+    const size_t row_bytes = c->glyph_len / c->height;
+    switch (transform) {
+        case HEXFONT_TRANSFORM_PAGES:
+            __hexfont_bits_to_pages(out, c->glyph, row_bytes, c->height);
+            break;
+
+        case HEXFONT_TRANSFORM_ROTATE_90:
+        case HEXFONT_TRANSFORM_ROTATE_270:
+            __hexfont_transform_rotate(c, transform, out);
+            break;
+
+        default:
+            __hexfont_transform_flip(c, transform, out);
+            break;
+    }
+}
+
+hexfont_transform_cache * const hexfont_transform_cache_create(hexfont * const font, const hexfont_transform transform, const bool precompute) {
+    hexfont_transform_cache * const cache = malloc(sizeof(hexfont_transform_cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    cache->font = font;
+    cache->transform = transform;
+    cache->slots = calloc(font->length > 0 ? font->length : 1, sizeof(hexfont_transformed));
+    cache->arena = __hexfont_arena_create();
+    pthread_mutex_init(&cache->lock, NULL);
+    if (cache->slots == NULL || cache->arena == NULL) {
+        hexfont_transform_cache_destroy(cache);
+        return NULL;
+    }
+
+    // Characters which fail to decode are left for hexfont_transform_cache_get to report
+    if (precompute) {
+        uint32_t i = 0;
+        for (i=0; i<font->length; i++) {
+            if (__hexfont_transform_cache_fill(cache, i) == NULL &&
+                __hexfont_character_at(font, i) != NULL) {
+                hexfont_transform_cache_destroy(cache);
+                return NULL;
+            }
+        }
+    }
+
+    return cache;
+}
+
+const hexfont_transformed * const hexfont_transform_cache_get(hexfont_transform_cache * const cache, const uint32_t codepoint) {
+    const uint32_t number = __hexfont_find(cache->font, codepoint);
+    if (number == 0) {
+        return NULL;
+    }
+
+    const hexfont_transformed * const slot = &cache->slots[number - 1];
+    if (__atomic_load_n(&slot->data, __ATOMIC_ACQUIRE) != NULL) {
+        return slot;
+    }
+
+    return __hexfont_transform_cache_fill(cache, number - 1);
+}
+
+void hexfont_transform_cache_destroy(hexfont_transform_cache * const cache) {
+    pthread_mutex_destroy(&cache->lock);
+    __hexfont_arena_destroy(cache->arena);
+    free(cache->slots);
+    free(cache);
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static void __hexfont_transform_geometry(const hexfont_character * const c, const hexfont_transform transform, hexfont_transformed * const result) {
+    const size_t row_bytes = c->glyph_len / c->height;
+    const size_t width = row_bytes * HEXFONT_BYTE_WIDTH;
+    const size_t pages = (c->height + HEXFONT_BITS_PAGE_ROWS - 1) / HEXFONT_BITS_PAGE_ROWS;
+
+    result->data = NULL;
+    switch (transform) {
+        case HEXFONT_TRANSFORM_PAGES:
+            result->width = width;
+            result->height = c->height;
+            result->stride = width;
+            result->len = pages * width;
+            break;
+
+        case HEXFONT_TRANSFORM_ROTATE_90:
+        case HEXFONT_TRANSFORM_ROTATE_270:
+            result->width = c->height;
+            result->height = width;
+            result->stride = pages;
+            result->len = width * pages;
+            break;
+
+        default:
+            result->width = width;
+            result->height = c->height;
+            result->stride = row_bytes;
+            result->len = row_bytes * c->height;
+            break;
+    }
+}
+
+/**
+ * Quarter turns, the glyph is converted to pages, each page byte then is
+ * 8 pixels of a column which become 8 pixels of a row of the output
+*/
+static void __hexfont_transform_rotate(const hexfont_character * const c, const hexfont_transform transform, uint8_t * const out) {
+    const size_t row_bytes = c->glyph_len / c->height;
+    const size_t width = row_bytes * HEXFONT_BYTE_WIDTH;
+    const size_t pages = (c->height + HEXFONT_BITS_PAGE_ROWS - 1) / HEXFONT_BITS_PAGE_ROWS;
+
+    uint8_t buffer[HEXFONT_TRANSFORM_STACK_BUFFER];
+    uint8_t * const columns = (pages * width <= sizeof(buffer)) ? buffer : malloc(pages * width);
+    if (columns == NULL) {
+        memset(out, 0, pages * width);
+        return;
+    }
+    __hexfont_bits_to_pages(columns, c->glyph, row_bytes, c->height);
+
+    size_t y = 0;
+    size_t k = 0;
+    if (transform == HEXFONT_TRANSFORM_ROTATE_90) {
+        // Row y is column y read from the bottom, which is the top bit of the last page
+        const size_t pad = pages * HEXFONT_BITS_PAGE_ROWS - c->height;
+        for (y=0; y<width; y++) {
+            uint8_t * const row = out + y * pages;
+            for (k=0; k<pages; k++) {
+                row[k] = columns[(pages - 1 - k) * width + y];
+            }
+
+            // Blank rows below a partial last page would be on the left, move them off
+            if (pad > 0) {
+                for (k=0; k<pages; k++) {
+                    row[k] = (uint8_t)((row[k] << pad) | ((k + 1 < pages) ? row[k + 1] >> (8 - pad) : 0));
+                }
+            }
+        }
+    }
+    else {
+        // Row y is column width - 1 - y read from the top
+        for (y=0; y<width; y++) {
+            uint8_t * const row = out + y * pages;
+            for (k=0; k<pages; k++) {
+                row[k] = __hexfont_bits_reverse[columns[k * width + (width - 1 - y)]];
+            }
+        }
+    }
+
+    if (columns != buffer) {
+        free(columns);
+    }
+}
+
+// Half turn and mirror images, which keep rows as rows
+static void __hexfont_transform_flip(const hexfont_character * const c, const hexfont_transform transform, uint8_t * const out) {
+    const size_t row_bytes = c->glyph_len / c->height;
+    const bool flip_x = (transform == HEXFONT_TRANSFORM_ROTATE_180 || transform == HEXFONT_TRANSFORM_MIRROR_X);
+    const bool flip_y = (transform == HEXFONT_TRANSFORM_ROTATE_180 || transform == HEXFONT_TRANSFORM_MIRROR_Y);
+
+    size_t y = 0;
+    for (y=0; y<c->height; y++) {
+        const uint8_t * const src = c->glyph + ((flip_y) ? c->height - 1 - y : y) * row_bytes;
+        uint8_t * const dst = out + y * row_bytes;
+
+        if (!flip_x) {
+            memcpy(dst, src, row_bytes);
+            continue;
+        }
+
+        size_t k = 0;
+        for (k=0; k<row_bytes; k++) {
+            dst[k] = __hexfont_bits_reverse[src[row_bytes - 1 - k]];
+        }
+    }
+}
+
+static const hexfont_transformed * const __hexfont_transform_cache_fill(hexfont_transform_cache * const cache, const uint32_t index) {
+    hexfont_transformed * const slot = &cache->slots[index];
+
+    pthread_mutex_lock(&cache->lock);
+
+    // Another thread may have got here first
+    if (slot->data == NULL) {
+        hexfont_character * const c = __hexfont_character_at(cache->font, index);
+        const size_t len = (c) ? hexfont_transform_size(c, cache->transform) : 0;
+        uint8_t * const data = (c) ? __hexfont_arena_alloc(cache->arena, (len > 0) ? len : 1, 1) : NULL;
+        if (data == NULL) {
+            pthread_mutex_unlock(&cache->lock);
+            return NULL;
+        }
+
+        hexfont_transformed result;
+        hexfont_transform_character(c, cache->transform, data, &result);
+        slot->len = result.len;
+        slot->stride = result.stride;
+        slot->width = result.width;
+        slot->height = result.height;
+        __atomic_store_n(&slot->data, result.data, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return slot;
+}
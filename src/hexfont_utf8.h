@@ -0,0 +1,144 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEXFONT_UTF8_H__
+#define __HEXFONT_UTF8_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Returned for malformed sequences
+#define HEXFONT_UTF8_REPLACEMENT_CHARACTER 0xfffd
+
+/**
+ * Decode the codepoint at *p and advance *p past it, never reading at or
+ * beyond end. Malformed, overlong and surrogate sequences consume one byte
+ * and give HEXFONT_UTF8_REPLACEMENT_CHARACTER.
+  */
+static inline const uint32_t __hexfont_utf8_next(const char ** const p, const char * const end) {
+    const uint8_t *s = (const uint8_t *)*p;
+    const size_t available = (const uint8_t *)end - s;
+    const uint8_t b0 = s[0];
+
+    if (b0 < 0x80) {
+        *p += 1;
+        return b0;
+    }
+
+    uint32_t codepoint;
+    size_t len;
+    uint32_t min;
+    if ((b0 & 0xe0) == 0xc0) {
+        codepoint = b0 & 0x1f;
+        len = 2;
+        min = 0x80;
+    }
+    else if ((b0 & 0xf0) == 0xe0) {
+        codepoint = b0 & 0x0f;
+        len = 3;
+        min = 0x800;
+    }
+    else if ((b0 & 0xf8) == 0xf0) {
+        codepoint = b0 & 0x07;
+        len = 4;
+        min = 0x10000;
+    }
+    else {
+        *p += 1;
+        return HEXFONT_UTF8_REPLACEMENT_CHARACTER;
+    }
+
+    if (available < len) {
+        *p += 1;
+        return HEXFONT_UTF8_REPLACEMENT_CHARACTER;
+    }
+
+    size_t i = 1;
+    for (i=1; i<len; i++) {
+        if ((s[i] & 0xc0) != 0x80) {
+            *p += 1;
+            return HEXFONT_UTF8_REPLACEMENT_CHARACTER;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3f);
+    }
+
+    if (codepoint < min || codepoint > 0x10ffff ||
+        (codepoint >= 0xd800 && codepoint <= 0xdfff)) {
+        *p += 1;
+        return HEXFONT_UTF8_REPLACEMENT_CHARACTER;
+    }
+
+    *p += len;
+    return codepoint;
+}
+
+/**
+ * Decode up to max codepoints of text into codepoints and return how
+ * many there were, consumed is set to the number of bytes they took.
+ * Eight ASCII bytes are checked at once and widened without branches.
+  */
+static inline const size_t __hexfont_utf8_decode_batch(const char * const text, const size_t len, uint32_t * const codepoints, const size_t max, size_t * const consumed) {
+    const char * const end = text + len;
+    const char *p = text;
+    size_t count = 0;
+
+    while (count < max && p < end) {
+        const uint8_t b = (uint8_t)*p;
+        if (b >= 0x80) {
+            codepoints[count++] = __hexfont_utf8_next(&p, end);
+            continue;
+        }
+
+        // An ASCII byte is often the start of a run of them
+        if (end - p >= 8 && max - count >= 8) {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+            if ((word & 0x8080808080808080ULL) == 0) {
+                size_t k = 0;
+                for (k=0; k<8; k++) {
+                    codepoints[count + k] = (uint8_t)p[k];
+                }
+                count += 8;
+                p += 8;
+                continue;
+            }
+        }
+
+        codepoints[count++] = b;
+        p++;
+    }
+
+    *consumed = p - text;
+    return count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HEXFONT_UTF8_H__
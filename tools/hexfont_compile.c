@@ -0,0 +1,57 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "hexfont.h"
+
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <font.hex> <glyph_height> <output>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char *endptr;
+    const uint16_t glyph_height = strtol(argv[2], &endptr, 10);
+    if (*endptr != '\0' || glyph_height == 0) {
+        fprintf(stderr, "Invalid glyph height: %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    hexfont * const font = hexfont_load(argv[1], glyph_height);
+    if (font == NULL) {
+        fprintf(stderr, "Could not load font: %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (!hexfont_save_binary(font, argv[3])) {
+        fprintf(stderr, "Could not write compiled font: %s\n", argv[3]);
+        hexfont_destroy(font);
+        return EXIT_FAILURE;
+    }
+
+    hexfont_destroy(font);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hexfont.h"
+
+// Number of values written on each line of an array
+#define HEXFONT_EMBED_BYTES_PER_LINE 16
+#define HEXFONT_EMBED_WORDS_PER_LINE 8
+
+static const bool hexfont_embed_write(hexfont * const font, const char *source, const char *name, FILE *fp);
+static void hexfont_embed_write_words(FILE *fp, const char *name, const char *suffix, const uint32_t *words, const size_t length);
+static const bool hexfont_embed_valid_name(const char *name);
+
+
+int main(int argc, char **argv) {
+    if (argc != 5) {
+        fprintf(stderr, "Usage: %s <font.hex> <glyph_height> <name> <output.h>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char *endptr;
+    const uint16_t glyph_height = strtol(argv[2], &endptr, 10);
+    if (*endptr != '\0' || glyph_height == 0) {
+        fprintf(stderr, "Invalid glyph height: %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    if (!hexfont_embed_valid_name(argv[3])) {
+        fprintf(stderr, "Invalid name, must be a C identifier: %s\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    hexfont * const font = hexfont_load(argv[1], glyph_height);
+    if (font == NULL) {
+        fprintf(stderr, "Could not load font: %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    FILE * const fp = fopen(argv[4], "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Could not open output: %s\n", argv[4]);
+        hexfont_destroy(font);
+        return EXIT_FAILURE;
+    }
+
+    // Base name of the source, so that the output doesn't depend on where it was built
+    const char * const slash = strrchr(argv[1], '/');
+    const char * const source = (slash) ? slash + 1 : argv[1];
+
+    bool ok = hexfont_embed_write(font, source, argv[3], fp);
+    ok = (fclose(fp) == 0) && ok;
+    hexfont_destroy(font);
+
+    if (!ok) {
+        fprintf(stderr, "Could not write embedded font: %s\n", argv[4]);
+        remove(argv[4]);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+
+/**
+ * Write a header which defines the font as const tables, with the glyphs
+ * and characters in the same order as in font->characters so that the
+ * lookup table can be copied as it is.
+*/
+static const bool hexfont_embed_write(hexfont * const font, const char *source, const char *name, FILE *fp) {
+    uint32_t i = 0;
+    size_t j = 0;
+
+    fprintf(fp, "/**\n");
+    fprintf(fp, " * Generated by hexfont_embed from %s, do not edit.\n", source);
+    fprintf(fp, " *\n");
+    fprintf(fp, " * Include this in one translation unit and use %s() wherever a\n", name);
+    fprintf(fp, " * hexfont is needed. Nothing is parsed or allocated at runtime, and\n");
+    fprintf(fp, " * hexfont_destroy may be called on the font but does nothing.\n");
+    fprintf(fp, " */\n\n");
+    // Include guard in upper case
+    char guard[256];
+    for (j=0; name[j] && j<sizeof(guard)-1; j++) {
+        guard[j] = toupper((unsigned char)name[j]);
+    }
+    guard[j] = '\0';
+
+    fprintf(fp, "#ifndef __HEXFONT_EMBED_%s_H__\n", guard);
+    fprintf(fp, "#define __HEXFONT_EMBED_%s_H__\n\n", guard);
+    fprintf(fp, "#include \"hexfont.h\"\n\n");
+
+    // Glyphs of all characters, back to back
+    size_t glyphs_size = 0;
+    for (i=0; i<font->length; i++) {
+        glyphs_size += font->characters[i].glyph_len;
+    }
+
+    fprintf(fp, "static const uint8_t %s_glyphs[%zu] = {", name, (glyphs_size > 0) ? glyphs_size : 1);
+    size_t column = 0;
+    for (i=0; i<font->length; i++) {
+        const hexfont_character * const c = &font->characters[i];
+        for (j=0; j<c->glyph_len; j++) {
+            fprintf(fp, "%s0x%02x,", (column++ % HEXFONT_EMBED_BYTES_PER_LINE == 0) ? "\n    " : " ", c->glyph[j]);
+        }
+    }
+    fprintf(fp, "%s};\n\n", (glyphs_size > 0) ? "\n" : "0 ");
+
+    fprintf(fp, "static const hexfont_character %s_characters[%u] = {\n", name, (font->length > 0) ? font->length : 1);
+    size_t offset = 0;
+    for (i=0; i<font->length; i++) {
+        const hexfont_character * const c = &font->characters[i];
+        fprintf(fp, "    { 0x%04x, (uint8_t *)&%s_glyphs[%zu], %zu, %u, %u },\n",
+                c->codepoint,
+                name,
+                offset,
+                c->glyph_len,
+                c->width,
+                c->height);
+        offset += c->glyph_len;
+    }
+    if (font->length == 0) {
+        fprintf(fp, "    { 0 },\n");
+    }
+    fprintf(fp, "};\n\n");
+
+    fprintf(fp, "static const hexfont_metrics %s_metrics[%u] = {\n", name, (font->length > 0) ? font->length : 1);
+    for (i=0; i<font->length; i++) {
+        const hexfont_metrics * const m = &font->metrics[i];
+        fprintf(fp, "    { %u, %u, %u, %u, %u, %u, %u },\n",
+                m->ink_x,
+                m->ink_y,
+                m->ink_width,
+                m->ink_height,
+                m->left_bearing,
+                m->right_bearing,
+                m->advance);
+    }
+    if (font->length == 0) {
+        fprintf(fp, "    { 0 },\n");
+    }
+    fprintf(fp, "};\n\n");
+
+    // Pages are numbered from 0, so the highest number tells how many there are
+    uint32_t page_count = 1;
+    for (i=0; i<font->directory_length; i++) {
+        if (font->directory[i] + 1 > page_count) {
+            page_count = font->directory[i] + 1;
+        }
+    }
+
+    hexfont_embed_write_words(fp, name, "directory", font->directory, font->directory_length);
+    hexfont_embed_write_words(fp, name, "pages", font->pages, (font->pages) ? (size_t)page_count * HEXFONT_PAGE_SIZE : 0);
+
+    fprintf(fp, "static const hexfont %s_font = {\n", name);
+    fprintf(fp, "    .directory = %s_directory,\n", name);
+    fprintf(fp, "    .pages = %s_pages,\n", name);
+    fprintf(fp, "    .directory_length = %u,\n", font->directory_length);
+    fprintf(fp, "    .characters = (hexfont_character *)%s_characters,\n", name);
+    fprintf(fp, "    .length = %u,\n", font->length);
+    fprintf(fp, "    .metrics = (hexfont_metrics *)%s_metrics,\n", name);
+    fprintf(fp, "    .glyph_height = %u,\n", font->glyph_height);
+    fprintf(fp, "    .arena = NULL,\n");
+    fprintf(fp, "    .source = NULL,\n");
+    fprintf(fp, "    .embedded = true,\n");
+    fprintf(fp, "};\n\n");
+
+    fprintf(fp, "// The font and its characters are read only\n");
+    fprintf(fp, "static inline hexfont * const %s(void) {\n", name);
+    fprintf(fp, "    return (hexfont *)&%s_font;\n", name);
+    fprintf(fp, "}\n\n");
+
+    fprintf(fp, "#endif // __HEXFONT_EMBED_%s_H__\n", guard);
+
+    return !ferror(fp);
+}
+
+static void hexfont_embed_write_words(FILE *fp, const char *name, const char *suffix, const uint32_t *words, const size_t length) {
+    fprintf(fp, "static const uint32_t %s_%s[%zu] = {", name, suffix, (length > 0) ? length : 1);
+
+    size_t i = 0;
+    for (i=0; i<length; i++) {
+        fprintf(fp, "%s%u,", (i % HEXFONT_EMBED_WORDS_PER_LINE == 0) ? "\n    " : " ", words[i]);
+    }
+    fprintf(fp, "%s};\n\n", (length > 0) ? "\n" : "0 ");
+}
+
+static const bool hexfont_embed_valid_name(const char *name) {
+    if (!isalpha((unsigned char)name[0]) && name[0] != '_') {
+        return false;
+    }
+
+    const char *p;
+    for (p=name; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '_') {
+            return false;
+        }
+    }
+
+    return true;
+}
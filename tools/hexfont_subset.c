@@ -0,0 +1,146 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hexfont.h"
+#include "hexfont_subset.h"
+
+static const bool hexfont_subset_parse_range(const char *arg, uint32_t * const first, uint32_t * const last);
+static const bool hexfont_subset_ends_with(const char *s, const char *suffix);
+static const uint32_t hexfont_subset_count_written(hexfont * const font);
+
+
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        fprintf(stderr, "Usage: %s <font.hex> <glyph_height> <output> <corpus|U+XXXX[-YYYY]>...\n", argv[0]);
+        fprintf(stderr, "Writes a .hex file if output ends in .hex, otherwise a compiled font\n");
+        return EXIT_FAILURE;
+    }
+
+    char *endptr;
+    const uint16_t glyph_height = strtol(argv[2], &endptr, 10);
+    if (*endptr != '\0' || glyph_height == 0) {
+        fprintf(stderr, "Invalid glyph height: %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    hexfont_subset * const subset = hexfont_subset_create();
+    if (subset == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    // Every corpus is scanned in a single streaming pass
+    int i = 0;
+    for (i=4; i<argc; i++) {
+        uint32_t first, last;
+        if (strncmp(argv[i], "U+", 2) == 0) {
+            if (!hexfont_subset_parse_range(argv[i] + 2, &first, &last)) {
+                fprintf(stderr, "Invalid range: %s\n", argv[i]);
+                hexfont_subset_destroy(subset);
+                return EXIT_FAILURE;
+            }
+            hexfont_subset_add_range(subset, first, last);
+        }
+        else if (!hexfont_subset_add_file(subset, argv[i])) {
+            fprintf(stderr, "Could not read corpus: %s\n", argv[i]);
+            hexfont_subset_destroy(subset);
+            return EXIT_FAILURE;
+        }
+    }
+
+    hexfont * const font = hexfont_load_subset(argv[1], glyph_height, 0, subset);
+    if (font == NULL) {
+        fprintf(stderr, "Could not load font: %s\n", argv[1]);
+        hexfont_subset_destroy(subset);
+        return EXIT_FAILURE;
+    }
+
+    const bool ok = hexfont_subset_ends_with(argv[3], ".hex") ?
+                        hexfont_save_hex(font, argv[3]) :
+                        hexfont_save_binary(font, argv[3]);
+    if (!ok) {
+        fprintf(stderr, "Could not write font: %s\n", argv[3]);
+    }
+    else {
+        fprintf(stderr, "%u codepoints wanted, %u glyphs written\n",
+                hexfont_subset_count(subset), hexfont_subset_count_written(font));
+    }
+
+    hexfont_destroy(font);
+    hexfont_subset_destroy(subset);
+
+    return (ok) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+
+// Parse "XXXX" or "XXXX-YYYY", in hex
+static const bool hexfont_subset_parse_range(const char *arg, uint32_t * const first, uint32_t * const last) {
+    char *endptr;
+    const unsigned long start = strtoul(arg, &endptr, 16);
+    if (endptr == arg || start > HEXFONT_MAX_CODEPOINT) {
+        return false;
+    }
+
+    unsigned long stop = start;
+    if (*endptr == '-') {
+        const char * const second = endptr + 1;
+        stop = strtoul(second, &endptr, 16);
+        if (endptr == second || stop < start || stop > HEXFONT_MAX_CODEPOINT) {
+            return false;
+        }
+    }
+
+    *first = start;
+    *last = stop;
+    return *endptr == '\0';
+}
+
+static const bool hexfont_subset_ends_with(const char *s, const char *suffix) {
+    const size_t len = strlen(s);
+    const size_t suffix_len = strlen(suffix);
+
+    return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+// Codepoints hexfont_get finds a character for, which is what both formats write
+static const uint32_t hexfont_subset_count_written(hexfont * const font) {
+    uint32_t count = 0;
+    uint32_t block = 0;
+    for (block=0; block<font->directory_length; block++) {
+        if (font->directory[block] == 0) {
+            continue;
+        }
+
+        uint32_t i = 0;
+        for (i=0; i<HEXFONT_PAGE_SIZE; i++) {
+            count += (hexfont_get(font, (block << HEXFONT_PAGE_BITS) | i) != NULL);
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,109 @@
+/**
+ * libhexfont
+ *
+ * A library for reading and using fonts encoded in the unifont hex format
+ *
+ * Copyright 2015, Konrad Markus <konker@luxvelocitas.com>
+ *
+ * This file is part of libhexfont
+ *
+ * libhexfont is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libhexfont is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libhexfont.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hexfont.h"
+#include "hexfont_term.h"
+
+// An overview page is this many characters across and down
+#define HEXFONT_VIEW_COLUMNS 16
+#define HEXFONT_VIEW_ROWS 16
+
+static const bool hexfont_view_parse_mode(const char *arg, hexfont_term_mode * const mode);
+
+
+int main(int argc, char **argv) {
+    if (argc != 5) {
+        fprintf(stderr, "Usage: %s <font.hex> <glyph_height> <ascii|half|braille|sixel> <text|U+XXXX>\n", argv[0]);
+        fprintf(stderr, "U+XXXX shows the page of %d characters which holds the codepoint\n", HEXFONT_VIEW_COLUMNS * HEXFONT_VIEW_ROWS);
+        return EXIT_FAILURE;
+    }
+
+    char *endptr;
+    const uint16_t glyph_height = strtol(argv[2], &endptr, 10);
+    if (*endptr != '\0' || glyph_height == 0) {
+        fprintf(stderr, "Invalid glyph height: %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    hexfont_term_mode mode;
+    if (!hexfont_view_parse_mode(argv[3], &mode)) {
+        fprintf(stderr, "Invalid mode: %s\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    uint32_t codepoint = 0;
+    const bool overview = (strncmp(argv[4], "U+", 2) == 0);
+    if (overview) {
+        codepoint = strtoul(argv[4] + 2, &endptr, 16);
+        if (*endptr != '\0' || endptr == argv[4] + 2 || codepoint > HEXFONT_MAX_CODEPOINT) {
+            fprintf(stderr, "Invalid codepoint: %s\n", argv[4]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Only the glyphs which are shown are decoded
+    hexfont * const font = hexfont_load_lazy(argv[1], glyph_height);
+    if (font == NULL) {
+        fprintf(stderr, "Could not load font: %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    const uint32_t page = HEXFONT_VIEW_COLUMNS * HEXFONT_VIEW_ROWS;
+    const bool ok = (overview) ?
+            hexfont_term_write_overview(font, codepoint - (codepoint % page), HEXFONT_VIEW_COLUMNS, HEXFONT_VIEW_ROWS, mode, STDOUT_FILENO) :
+            hexfont_term_write_utf8(font, argv[4], mode, STDOUT_FILENO);
+
+    hexfont_destroy(font);
+    if (!ok) {
+        fprintf(stderr, "Could not write to the terminal\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
+// Static helpers
+static const bool hexfont_view_parse_mode(const char *arg, hexfont_term_mode * const mode) {
+    static const char * const names[] = { "ascii", "half", "braille", "sixel" };
+    static const hexfont_term_mode modes[] = {
+        HEXFONT_TERM_ASCII,
+        HEXFONT_TERM_HALF_BLOCKS,
+        HEXFONT_TERM_BRAILLE,
+        HEXFONT_TERM_SIXEL,
+    };
+
+    size_t i = 0;
+    for (i=0; i<sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(arg, names[i]) == 0) {
+            *mode = modes[i];
+            return true;
+        }
+    }
+
+    return false;
+}